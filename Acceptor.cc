@@ -1,12 +1,17 @@
 #include "Acceptor.h"
 #include "Logger.h"
 #include "InetAddress.h"
+#include "EventLoop.h"
 
 #include <sys/types.h>        
 #include <sys/socket.h>
 #include <netinet/tcp.h>
 #include <errno.h>
 #include <unistd.h>
+#include <fcntl.h>
+
+//fd用完且没有预留的fd时 暂停accept的时间
+static const double kPauseSecondsOnExhausted = 0.1;
 
 static int createNonblocking()
 {
@@ -24,12 +29,13 @@ Acceptor::Acceptor(EventLoop *loop, const InetAddress &listenAddr, bool reusepor
             :   loop_(loop),
                 acceptSocket_(createNonblocking()),//创建  socket
                 acceptChannel_(loop, acceptSocket_.fd()),
-                listenning_(false)
+                listenning_(false),
+                idleFd_(::open("/dev/null", O_RDONLY | O_CLOEXEC))
 
 
 {
     acceptSocket_.setReuseAddr(true);
-    acceptSocket_.setReusePort(true);
+    acceptSocket_.setReusePort(reuseport);
     acceptSocket_.bindAddress(listenAddr);//绑定 bind
     //TcpServer::start()  Acceptor.listen 有新用户连接 
     //执行一个回调 (将与新用户连接的connfd 打包成一个Channel  通过轮询 唤醒一个subloop)
@@ -40,10 +46,17 @@ Acceptor::Acceptor(EventLoop *loop, const InetAddress &listenAddr, bool reusepor
 
 Acceptor::~Acceptor()
 {
+    loop_->cancel(resumeTimer_);
     acceptChannel_.disableAll();
     acceptChannel_.remove();
+    if(idleFd_ >= 0)
+    {
+        ::close(idleFd_);
+    }
 }
 
+const int Acceptor::kMaxAcceptsPerEvent;
+
 void Acceptor::listen()
 {
     listenning_ = true;
@@ -53,31 +66,86 @@ void Acceptor::listen()
 }
 
 //listenfd有事件发生 ：有新用户连接
+//连接很多时一次poll返回只accept一个 每个连接都要一轮epoll_wait  这里一直accept到EAGAIN(最多kMaxAcceptsPerEvent个)
 void Acceptor::handleRead()
 {
-    InetAddress peerAddr;
-    int connfd = acceptSocket_.accept(&peerAddr);
-    if(connfd >= 0)
+    //上次没能把预留的fd占回来 有fd空出来后再补上 否则EMFILE时无法丢弃连接 loop会空转
+    if(idleFd_ < 0)
+    {
+        idleFd_ = ::open("/dev/null", O_RDONLY | O_CLOEXEC);
+    }
+    for(int i = 0; i < kMaxAcceptsPerEvent; ++i)
     {
-        if(newConnectionCallback_)
+        InetAddress peerAddr;
+        int connfd = acceptSocket_.accept(&peerAddr);
+        if(connfd >= 0)
         {
-            //轮询找到subloop 唤醒 分发当前新连接的Channel
-            newConnectionCallback_(connfd, peerAddr);
+            if(newConnectionCallback_)
+            {
+                //轮询找到subloop 唤醒 分发当前新连接的Channel
+                newConnectionCallback_(connfd, peerAddr);
+            }
+            else
+            {
+                ::close(connfd);
+            }
+            continue;
         }
-        else
+
+        const int savedErrno = errno;
+        if(savedErrno == EAGAIN || savedErrno == EWOULDBLOCK)
         {
-            ::close(connfd);
+            break;  //已经取完
         }
-    }
-    else
-    {
-        LOG_ERROR("%s : %s : %d  accept err: %d \n",
-                    __FILE__, __FUNCTION__, __LINE__, errno);
-        if(errno == EMFILE)
+        if(savedErrno == ECONNABORTED || savedErrno == EINTR)
         {
-            LOG_ERROR("%s : %s : %d sockfd reached limit \n",
-                    __FILE__, __FUNCTION__, __LINE__);
+            continue;   //对端在accept之前断开了 接着取下一个
         }
+        if(savedErrno == EMFILE || savedErrno == ENFILE)
+        {
+            if(dropConnection())
+            {
+                continue;
+            }
+            pauseAccepting();
+            break;
+        }
+        LOG_ERROR("%s : %s : %d  accept err: %d \n",
+                    __FILE__, __FUNCTION__, __LINE__, savedErrno);
+        break;
     }
 
-}
\ No newline at end of file
+}
+
+bool Acceptor::dropConnection()
+{
+    if(idleFd_ < 0)
+    {
+        return false;
+    }
+    LOG_ERROR("%s : %s : %d sockfd reached limit, drop a connection \n",
+            __FILE__, __FUNCTION__, __LINE__);
+    ::close(idleFd_);
+    int connfd = ::accept(acceptSocket_.fd(), nullptr, nullptr);
+    if(connfd >= 0)
+    {
+        ::close(connfd);
+    }
+    //别的线程可能抢先用掉了腾出的位置 这时为-1 下一次handleRead再重新打开
+    idleFd_ = ::open("/dev/null", O_RDONLY | O_CLOEXEC);
+    return connfd >= 0;
+}
+
+void Acceptor::pauseAccepting()
+{
+    LOG_ERROR("%s : %s : %d sockfd reached limit and no idle fd, pause accepting \n",
+            __FILE__, __FUNCTION__, __LINE__);
+    acceptChannel_.disableReading();
+    resumeTimer_ = loop_->runAfter(kPauseSecondsOnExhausted, std::bind(&Acceptor::resumeAccepting, this));
+}
+
+void Acceptor::resumeAccepting()
+{
+    resumeTimer_ = TimerId();
+    acceptChannel_.enableReading();
+}
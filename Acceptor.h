@@ -2,6 +2,7 @@
 #include "noncopyable.h"
 #include "Socket.h"
 #include "Channel.h"
+#include "TimerId.h"
 
 #include <functional>
 
@@ -22,12 +23,32 @@ public:
 
     bool listenning() const { return listenning_; }
     void listen();
+
+    //只有客户端先发数据的协议才能打开 服务端先说话的协议(如SMTP)会等到超时  见Socket::setDeferAccept
+    void setDeferAccept(int seconds) { acceptSocket_.setDeferAccept(seconds); }
+
+    //见Socket::attachReusePortCpuSteering  需要在组里所有的Acceptor都listen之后调用
+    bool attachReusePortCpuSteering(int numListeners)
+    {
+        return acceptSocket_.attachReusePortCpuSteering(numListeners);
+    }
 private:
+    //一次可读事件最多accept的连接数 剩下的等下一轮poll 不让accept占满loop
+    static const int kMaxAcceptsPerEvent = 64;
+
     void handleRead();
+    //fd用完时accept不出连接 监听fd一直可读 loop会空转
+    //关掉预留的fd腾出一个位置 accept后马上关闭(对端收到FIN) 再把预留的fd占回来
+    bool dropConnection();
+    //连预留的fd都没有 停止监听一小段时间再恢复 期间新连接留在backlog里
+    void pauseAccepting();
+    void resumeAccepting();
     
     EventLoop *loop_; // Acceptor用的就是用户定义的那个baseLoop，也称作mainLoop
     Socket acceptSocket_;
     Channel acceptChannel_;
     NewConnectionCallback newConnectionCallback_;
     bool listenning_;
+    int idleFd_;    //预留的fd 打开的/dev/null
+    TimerId resumeTimer_;
 };
\ No newline at end of file
@@ -0,0 +1,247 @@
+#include "AsyncLogging.h"
+#include "Timestamp.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <limits.h>
+#include <stdio.h>
+#include <sys/uio.h>
+#include <errno.h>
+#include <chrono>
+
+AsyncLogging::AsyncLogging(const std::string &filename, int flushInterval)
+    :   flushInterval_(flushInterval),
+        filename_(filename),
+        fd_(-1),
+        running_(false),
+        started_(false),
+        thread_(std::bind(&AsyncLogging::threadFunc, this), "AsyncLogging"),
+        currentBuffer_(new LogBuffer),
+        nextBuffer_(new LogBuffer)
+{
+    buffers_.reserve(16);
+}
+
+AsyncLogging::~AsyncLogging()
+{
+    if(running_)
+    {
+        stop();
+    }
+}
+
+void AsyncLogging::start()
+{
+    fd_ = ::open(filename_.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if(fd_ < 0)
+    {
+        //Logger的输出可能就是自己 这里不能用LOG_XXX
+        fprintf(stderr, "AsyncLogging::start open %s failed\n", filename_.c_str());
+        return;
+    }
+    running_ = true;
+    started_ = true;
+    thread_.start();
+}
+
+void AsyncLogging::stop()
+{
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        running_ = false;
+        cond_.notify_one();
+    }
+    if(started_)
+    {
+        thread_.join();
+        started_ = false;
+    }
+    ::close(fd_);
+    fd_ = -1;
+}
+
+void AsyncLogging::append(const char *logline, size_t len)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    if(currentBuffer_->avail() > len)
+    {
+        currentBuffer_->append(logline, len);
+    }
+    else
+    {
+        //当前缓冲区写满 交给后端 换上预备的缓冲区
+        buffers_.push_back(std::move(currentBuffer_));
+        if(nextBuffer_)
+        {
+            currentBuffer_ = std::move(nextBuffer_);
+        }
+        else
+        {
+            currentBuffer_.reset(new LogBuffer); //前端写得太快 很少发生
+        }
+        currentBuffer_->append(logline, len);
+        cond_.notify_one();
+    }
+}
+
+void AsyncLogging::flush()
+{
+    std::unique_lock<std::mutex> writeLock(writeMutex_);
+    std::unique_lock<std::mutex> lock(mutex_);
+    if(fd_ < 0)
+    {
+        return;
+    }
+    buffers_.push_back(std::move(currentBuffer_));
+    writeBuffers(buffers_);
+    ::fdatasync(fd_);
+    //写过的缓冲区不能再交给后端 留给前端继续用
+    currentBuffer_ = std::move(buffers_.back());
+    currentBuffer_->reset();
+    buffers_.pop_back();
+    //前端可能已经用掉了nextBuffer_ 要补上 否则后端下一轮只取到一个缓冲区 补不齐自己的两个备用缓冲区
+    if(!nextBuffer_)
+    {
+        if(buffers_.empty())
+        {
+            nextBuffer_.reset(new LogBuffer);
+        }
+        else
+        {
+            nextBuffer_ = std::move(buffers_.back());
+            nextBuffer_->reset();
+        }
+    }
+    buffers_.clear();
+}
+
+void AsyncLogging::threadFunc()
+{
+    BufferPtr newBuffer1(new LogBuffer);
+    BufferPtr newBuffer2(new LogBuffer);
+    BufferVector buffersToWrite;
+    buffersToWrite.reserve(16);
+    Timestamp lastSync(Timestamp::now());
+
+    bool running = true;
+    while(running)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            if(buffers_.empty() && running_)
+            {
+                cond_.wait_for(lock, std::chrono::seconds(flushInterval_));
+            }
+        }
+
+        //等待时不持有writeMutex_ 否则flush要等到后端醒来
+        std::unique_lock<std::mutex> writeLock(writeMutex_);
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            running = running_;
+            //当前缓冲区无论是否写满都交给后端
+            buffers_.push_back(std::move(currentBuffer_));
+            currentBuffer_ = std::move(newBuffer1);
+            buffersToWrite.swap(buffers_);
+            if(!nextBuffer_)
+            {
+                nextBuffer_ = std::move(newBuffer2);
+            }
+        }
+
+        //前端产生日志的速度远大于写入速度 丢弃多余的日志 防止内存暴涨
+        if(buffersToWrite.size() > 25)
+        {
+            char buf[256];
+            int n = snprintf(buf, sizeof buf, "Dropped log messages at %s, %zu larger buffers\n",
+                    Timestamp::now().toString().c_str(), buffersToWrite.size() - 2);
+            fputs(buf, stderr);
+            buffersToWrite.resize(2);
+            buffersToWrite.back()->reset();
+            buffersToWrite.back()->append(buf, static_cast<size_t>(n));
+        }
+
+        writeBuffers(buffersToWrite);
+        writeLock.unlock();
+
+        //留两个缓冲区用来替换前端的缓冲区 其余的释放
+        if(buffersToWrite.size() > 2)
+        {
+            buffersToWrite.resize(2);
+        }
+        if(!newBuffer1)
+        {
+            newBuffer1 = std::move(buffersToWrite.back());
+            buffersToWrite.pop_back();
+            newBuffer1->reset();
+        }
+        if(!newBuffer2)
+        {
+            newBuffer2 = std::move(buffersToWrite.back());
+            buffersToWrite.pop_back();
+            newBuffer2->reset();
+        }
+        buffersToWrite.clear();
+
+        //定期把page cache中的日志落盘 不在每一行日志上flush
+        Timestamp now(Timestamp::now());
+        if(now.microSecondsSinceEpoch() - lastSync.microSecondsSinceEpoch()
+            >= static_cast<int64_t>(flushInterval_) * Timestamp::kMicroSecondsPerSecond)
+        {
+            ::fdatasync(fd_);
+            lastSync = now;
+        }
+    }
+    ::fdatasync(fd_);
+}
+
+//一次writev写入所有缓冲区  最多IOV_MAX个
+void AsyncLogging::writeBuffers(const BufferVector &buffers)
+{
+    struct iovec vec[IOV_MAX];
+    size_t i = 0;
+    while(i < buffers.size())
+    {
+        int iovcnt = 0;
+        size_t total = 0;
+        for(; i < buffers.size() && iovcnt < IOV_MAX; ++i)
+        {
+            if(buffers[i]->length() == 0)
+            {
+                continue;
+            }
+            vec[iovcnt].iov_base = const_cast<char*>(buffers[i]->data());
+            vec[iovcnt].iov_len = buffers[i]->length();
+            total += vec[iovcnt].iov_len;
+            ++iovcnt;
+        }
+
+        //处理部分写入
+        int first = 0;
+        while(total > 0 && first < iovcnt)
+        {
+            ssize_t n = ::writev(fd_, vec + first, iovcnt - first);
+            if(n < 0)
+            {
+                if(errno == EINTR)
+                {
+                    continue;
+                }
+                fprintf(stderr, "AsyncLogging::writeBuffers writev failed %d\n", errno);
+                break;
+            }
+            total -= static_cast<size_t>(n);
+            size_t written = static_cast<size_t>(n);
+            while(first < iovcnt && written >= vec[first].iov_len)
+            {
+                written -= vec[first].iov_len;
+                ++first;
+            }
+            if(first < iovcnt)
+            {
+                vec[first].iov_base = static_cast<char*>(vec[first].iov_base) + written;
+                vec[first].iov_len -= written;
+            }
+        }
+    }
+}
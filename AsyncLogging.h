@@ -0,0 +1,85 @@
+#pragma once
+
+#include "noncopyable.h"
+#include "Thread.h"
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include <string.h>
+
+/*
+异步日志  前端线程只把日志行拷贝进内存缓冲区 由后端线程批量写入文件
+    双缓冲: currentBuffer_写满后放入buffers_ 换上nextBuffer_  前端几乎不会分配内存
+    后端线程每隔flushInterval秒 或者有写满的缓冲区时被唤醒
+    交换出所有写满的缓冲区后 用一次writev写入文件 定期fdatasync
+用法:
+    AsyncLogging log("/tmp/server.log");
+    log.start();
+    Logger::setOutput(asyncOutput);  //asyncOutput内调用log.append
+    Logger::setFlush(asyncFlush);    //asyncFlush内调用log.flush  LOG_FATAL退出前把缓冲区里的日志写进文件
+*/
+class AsyncLogging : noncopyable
+{
+public:
+    AsyncLogging(const std::string &filename, int flushInterval = 3);
+    ~AsyncLogging();
+
+    //前端线程调用 线程安全
+    void append(const char *logline, size_t len);
+    //在调用线程中同步写入所有还在内存中的日志并fdatasync  供LOG_FATAL退出前调用
+    void flush();
+
+    void start();
+    void stop();
+
+private:
+    //固定大小的缓冲区 写满以后交给后端线程
+    class LogBuffer : noncopyable
+    {
+    public:
+        static const size_t kSize = 4 * 1024 * 1024;
+
+        LogBuffer() : cur_(data_) {}
+
+        size_t avail() const { return static_cast<size_t>(end() - cur_); }
+        size_t length() const { return static_cast<size_t>(cur_ - data_); }
+        const char* data() const { return data_; }
+
+        void append(const char *buf, size_t len)
+        {
+            memcpy(cur_, buf, len);
+            cur_ += len;
+        }
+        void reset() { cur_ = data_; }
+
+    private:
+        const char* end() const { return data_ + sizeof data_; }
+
+        char data_[kSize];
+        char *cur_;
+    };
+
+    using BufferPtr = std::unique_ptr<LogBuffer>;
+    using BufferVector = std::vector<BufferPtr>;
+
+    void threadFunc();  //后端线程
+    void writeBuffers(const BufferVector &buffers);
+
+    const int flushInterval_;
+    const std::string filename_;
+    int fd_;
+    std::atomic_bool running_;
+    bool started_;
+    Thread thread_;
+    //后端取走缓冲区到写完为止持有 flush先拿到它 保证文件中日志的顺序
+    std::mutex writeMutex_;
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    BufferPtr currentBuffer_;   //前端正在写的缓冲区
+    BufferPtr nextBuffer_;      //预备的缓冲区
+    BufferVector buffers_;      //已写满 等待后端写入的缓冲区
+};
@@ -0,0 +1,381 @@
+#include "BinaryLogging.h"
+#include "Timestamp.h"
+#include "CurrentThread.h"
+#include "Thread.h"
+
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <new>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+namespace
+{
+
+struct FormatInfo
+{
+    int level;
+    const char *file;
+    int line;
+    const char *format;
+    const char *signature;
+};
+
+//线程退出时标记环形缓冲区 由后端线程取完剩余记录后释放
+struct ThreadRingHolder
+{
+    BinaryLogRing *ring = nullptr;
+    ~ThreadRingHolder()
+    {
+        if(ring)
+        {
+            ring->abandon();
+        }
+    }
+};
+
+thread_local ThreadRingHolder t_holder;
+
+//后端  所有状态由mutex_保护  只有格式注册和线程第一次写日志时会加锁
+class Backend : noncopyable
+{
+public:
+    Backend()
+        :   fd_(-1),
+            running_(false),
+            flushIntervalMs_(100),
+            writtenFormats_(0)
+    {}
+
+    bool start(const std::string &filename, int flushIntervalMs);
+    void stop();
+
+    uint32_t registerFormat(const FormatInfo &info)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        formats_.push_back(info);
+        return static_cast<uint32_t>(formats_.size() - 1);
+    }
+
+    void addRing(BinaryLogRing *ring)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        rings_.push_back(ring);
+    }
+
+private:
+    void threadFunc();
+    //取走所有线程的记录并写入文件
+    void collect();
+    void appendDefinitions(std::string *out);
+    void writeAll(const std::string &data);
+
+    int fd_;
+    bool running_;
+    int flushIntervalMs_;
+    std::unique_ptr<Thread> thread_;
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    std::vector<FormatInfo> formats_;
+    size_t writtenFormats_;     //已经写入文件的格式定义个数  只在后端线程访问
+    std::vector<BinaryLogRing*> rings_;
+    std::string records_;       //后端线程复用的写缓冲
+};
+
+Backend& backend()
+{
+    static Backend instance;
+    return instance;
+}
+
+void appendRaw(std::string *out, const void *data, size_t len)
+{
+    out->append(static_cast<const char*>(data), len);
+}
+
+template<typename T>
+void appendPod(std::string *out, T value)
+{
+    appendRaw(out, &value, sizeof value);
+}
+
+bool Backend::start(const std::string &filename, int flushIntervalMs)
+{
+    fd_ = ::open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if(fd_ < 0)
+    {
+        fprintf(stderr, "BinaryLogging::start open %s failed %d\n", filename.c_str(), errno);
+        return false;
+    }
+    //新文件是空的 stop之后再start时 之前写过的格式定义要重新写
+    writtenFormats_ = 0;
+    std::string header("MYMDBLOG");
+    appendPod(&header, BinaryLogging::kVersion);
+    writeAll(header);
+
+    flushIntervalMs_ = flushIntervalMs;
+    running_ = true;
+    thread_.reset(new Thread(std::bind(&Backend::threadFunc, this), "BinaryLogging"));
+    thread_->start();
+    return true;
+}
+
+void Backend::stop()
+{
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        running_ = false;
+        cond_.notify_one();
+    }
+    thread_->join();
+    thread_.reset();
+    collect();
+    ::close(fd_);
+    fd_ = -1;
+}
+
+void Backend::threadFunc()
+{
+    while(true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            if(!running_)
+            {
+                break;
+            }
+            cond_.wait_for(lock, std::chrono::milliseconds(flushIntervalMs_));
+        }
+        collect();
+    }
+}
+
+void Backend::collect()
+{
+    std::vector<BinaryLogRing*> rings;
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        rings = rings_;
+    }
+
+    //先取记录再写格式定义 记录引用的格式ID一定已经注册
+    records_.clear();
+    std::string definitions;
+    std::vector<BinaryLogRing*> finished;
+    for(BinaryLogRing *ring : rings)
+    {
+        //先读abandoned 线程退出前提交的记录一定能被这次drain取到
+        bool abandoned = ring->abandoned();
+        ring->drain(&records_);
+        if(abandoned)
+        {
+            finished.push_back(ring);
+        }
+    }
+    appendDefinitions(&definitions);
+
+    if(!definitions.empty())
+    {
+        writeAll(definitions);
+    }
+    if(!records_.empty())
+    {
+        writeAll(records_);
+    }
+
+    if(!finished.empty())
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        for(BinaryLogRing *ring : finished)
+        {
+            for(size_t i = 0; i < rings_.size(); ++i)
+            {
+                if(rings_[i] == ring)
+                {
+                    rings_[i] = rings_.back();
+                    rings_.pop_back();
+                    break;
+                }
+            }
+            BinaryLogRing::destroy(ring);
+        }
+    }
+}
+
+void Backend::appendDefinitions(std::string *out)
+{
+    std::vector<FormatInfo> pending;
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        pending.assign(formats_.begin() + writtenFormats_, formats_.end());
+    }
+    for(const FormatInfo &info : pending)
+    {
+        uint32_t id = static_cast<uint32_t>(writtenFormats_++);
+        size_t fileLen = strlen(info.file) + 1;
+        size_t sigLen = strlen(info.signature) + 1;
+        size_t formatLen = strlen(info.format) + 1;
+        uint32_t len = static_cast<uint32_t>(4 + 4 + 4 + 4 + 4 + fileLen + sigLen + formatLen);
+        appendPod(out, len);
+        appendPod(out, BinaryLogging::kDefinitionId);
+        appendPod(out, id);
+        appendPod(out, static_cast<int32_t>(info.level));
+        appendPod(out, static_cast<int32_t>(info.line));
+        appendRaw(out, info.file, fileLen);
+        appendRaw(out, info.signature, sigLen);
+        appendRaw(out, info.format, formatLen);
+    }
+}
+
+void Backend::writeAll(const std::string &data)
+{
+    const char *p = data.data();
+    size_t remaining = data.size();
+    while(remaining > 0)
+    {
+        ssize_t n = ::write(fd_, p, remaining);
+        if(n < 0)
+        {
+            if(errno == EINTR)
+            {
+                continue;
+            }
+            fprintf(stderr, "BinaryLogging write failed %d\n", errno);
+            return;
+        }
+        p += n;
+        remaining -= static_cast<size_t>(n);
+    }
+}
+
+} // namespace
+
+const size_t BinaryLogRing::kSize;
+const uint32_t BinaryLogRing::kPadding;
+const uint32_t BinaryLogging::kVersion;
+const uint32_t BinaryLogging::kDefinitionId;
+const size_t BinaryLogging::kRecordHeaderSize;
+
+__thread BinaryLogRing *BinaryLogging::t_ring_ = nullptr;
+std::atomic_bool BinaryLogging::s_started_(false);
+std::atomic<uint64_t> BinaryLogging::s_dropped_(0);
+
+BinaryLogRing* BinaryLogRing::create()
+{
+    void *p = nullptr;
+    if(::posix_memalign(&p, alignof(BinaryLogRing), sizeof(BinaryLogRing)) != 0)
+    {
+        throw std::bad_alloc();
+    }
+    return new (p) BinaryLogRing;
+}
+
+void BinaryLogRing::destroy(BinaryLogRing *ring)
+{
+    ring->~BinaryLogRing();
+    ::free(ring);
+}
+
+char* BinaryLogRing::reserve(size_t len)
+{
+    const size_t aligned = align(len);
+    uint64_t head = head_.load(std::memory_order_relaxed);
+    size_t pos = static_cast<size_t>(head & (kSize - 1));
+    //环尾放不下 填充到环首
+    size_t padding = pos + aligned > kSize ? kSize - pos : 0;
+    if(head + padding + aligned - cachedTail_ > kSize)
+    {
+        cachedTail_ = tail_.load(std::memory_order_acquire);
+        if(head + padding + aligned - cachedTail_ > kSize)
+        {
+            return nullptr;
+        }
+    }
+    if(padding > 0)
+    {
+        memcpy(data_ + pos, &kPadding, sizeof kPadding);
+        pos = 0;
+    }
+    reserveEnd_ = head + padding + aligned;
+    return data_ + pos;
+}
+
+bool BinaryLogRing::drain(std::string *out)
+{
+    const uint64_t head = head_.load(std::memory_order_acquire);
+    uint64_t tail = tail_.load(std::memory_order_relaxed);
+    if(tail == head)
+    {
+        return false;
+    }
+    while(tail < head)
+    {
+        size_t pos = static_cast<size_t>(tail & (kSize - 1));
+        uint32_t len;
+        memcpy(&len, data_ + pos, sizeof len);
+        if(len == kPadding)
+        {
+            tail += kSize - pos;
+            continue;
+        }
+        out->append(data_ + pos, len);
+        tail += align(len);
+    }
+    tail_.store(tail, std::memory_order_release);
+    return true;
+}
+
+bool BinaryLogging::start(const std::string &filename, int flushIntervalMs)
+{
+    if(started())
+    {
+        return false;
+    }
+    if(!backend().start(filename, flushIntervalMs))
+    {
+        return false;
+    }
+    s_started_.store(true);
+    return true;
+}
+
+void BinaryLogging::stop()
+{
+    if(started())
+    {
+        s_started_.store(false);
+        backend().stop();
+    }
+}
+
+uint32_t BinaryLogging::registerFormat(int level, const char *file, int line,
+                                        const char *format, const char *signature)
+{
+    FormatInfo info = { level, file, line, format, signature };
+    return backend().registerFormat(info);
+}
+
+char* BinaryLogging::encodeHeader(char *p, uint32_t len, uint32_t formatId)
+{
+    int64_t now = Timestamp::now().microSecondsSinceEpoch();
+    int32_t tid = CurrentThread::tid();
+    memcpy(p, &len, sizeof len);
+    memcpy(p + 4, &formatId, sizeof formatId);
+    memcpy(p + 8, &now, sizeof now);
+    memcpy(p + 16, &tid, sizeof tid);
+    return p + kRecordHeaderSize;
+}
+
+BinaryLogRing* BinaryLogging::createThreadRing()
+{
+    BinaryLogRing *ring = BinaryLogRing::create();
+    t_holder.ring = ring;
+    backend().addRing(ring);
+    return ring;
+}
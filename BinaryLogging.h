@@ -0,0 +1,276 @@
+#pragma once
+
+#include "noncopyable.h"
+#include "Logger.h"
+
+#include <atomic>
+#include <string>
+#include <type_traits>
+#include <stdint.h>
+#include <string.h>
+
+/*
+二进制日志  调用线程不做snprintf 格式化推迟到离线的mymuduo-logdecode工具
+    每个调用点第一次执行时注册格式串 得到一个静态的格式ID
+    之后每次调用只把 [长度 格式ID 时间戳 tid 原始参数字节] 写进本线程的无锁环形缓冲区(单生产者单消费者)
+    后端线程定期取走所有线程的环形缓冲区中的记录 连同新注册的格式串一起写入文件
+参数类型在编译期检查: 只支持整数 枚举 浮点 C字符串和指针  格式串和参数通过printf的format属性检查
+用法:
+    BinaryLogging::start("/tmp/server.blog");
+    BLOG_INFO("fd = %d events = %d", fd, events);
+    ./mymuduo-logdecode /tmp/server.blog
+
+文件格式(小端):
+    文件头     "MYMDBLOG" + uint32 版本号
+    格式定义   uint32 长度 | uint32 kDefinitionId | uint32 格式ID | int32 级别 | int32 行号
+               | 文件名\0 | 参数签名\0 | 格式串\0
+    日志记录   uint32 长度 | uint32 格式ID | int64 时间戳(微秒) | int32 tid | 参数...
+参数编码:  'i' int64  'u' uint64  'd' double  'p' uint64  's' uint32长度 + 字节
+*/
+
+template<typename... Args>
+struct BinaryLogTypeList {};
+
+//参数类型的编码  不支持的类型在编译期报错
+template<typename T, typename Enable = void>
+struct BinaryLogArg
+{
+    static_assert(sizeof(T) == 0, "unsupported argument type for binary log");
+};
+
+template<typename T>
+struct BinaryLogArg<T, typename std::enable_if<(std::is_integral<T>::value && std::is_signed<T>::value)
+                                                || std::is_enum<T>::value>::type>
+{
+    static const char kType = 'i';
+    static size_t size(T) { return sizeof(int64_t); }
+    static char* encode(char *p, T v)
+    {
+        int64_t x = static_cast<int64_t>(v);
+        memcpy(p, &x, sizeof x);
+        return p + sizeof x;
+    }
+};
+
+template<typename T>
+struct BinaryLogArg<T, typename std::enable_if<std::is_integral<T>::value && std::is_unsigned<T>::value>::type>
+{
+    static const char kType = 'u';
+    static size_t size(T) { return sizeof(uint64_t); }
+    static char* encode(char *p, T v)
+    {
+        uint64_t x = static_cast<uint64_t>(v);
+        memcpy(p, &x, sizeof x);
+        return p + sizeof x;
+    }
+};
+
+template<typename T>
+struct BinaryLogArg<T, typename std::enable_if<std::is_floating_point<T>::value>::type>
+{
+    static const char kType = 'd';
+    static size_t size(T) { return sizeof(double); }
+    static char* encode(char *p, T v)
+    {
+        double x = static_cast<double>(v);
+        memcpy(p, &x, sizeof x);
+        return p + sizeof x;
+    }
+};
+
+//C字符串 拷贝内容
+template<typename T>
+struct BinaryLogArg<T, typename std::enable_if<std::is_same<T, const char*>::value
+                                                || std::is_same<T, char*>::value>::type>
+{
+    static const char kType = 's';
+    static size_t size(const char *s) { return sizeof(uint32_t) + (s ? strlen(s) : 6); }
+    static char* encode(char *p, const char *s)
+    {
+        if(s == nullptr)
+        {
+            s = "(null)";
+        }
+        uint32_t len = static_cast<uint32_t>(strlen(s));
+        memcpy(p, &len, sizeof len);
+        memcpy(p + sizeof len, s, len);
+        return p + sizeof len + len;
+    }
+};
+
+//其他指针 只记录地址
+template<typename T>
+struct BinaryLogArg<T, typename std::enable_if<std::is_pointer<T>::value
+                                                && !std::is_same<T, const char*>::value
+                                                && !std::is_same<T, char*>::value>::type>
+{
+    static const char kType = 'p';
+    static size_t size(T) { return sizeof(uint64_t); }
+    static char* encode(char *p, T v)
+    {
+        uint64_t x = reinterpret_cast<uintptr_t>(v);
+        memcpy(p, &x, sizeof x);
+        return p + sizeof x;
+    }
+};
+
+//参数签名 每种参数类型组合一个静态字符串 比如 "iis"
+template<typename List>
+struct BinaryLogSignature;
+
+template<typename... Args>
+struct BinaryLogSignature<BinaryLogTypeList<Args...>>
+{
+    static const char* value()
+    {
+        static const char signature[] = { BinaryLogArg<Args>::kType..., '\0' };
+        return signature;
+    }
+};
+
+//每个线程一个的环形缓冲区  调用线程是唯一的生产者 后端线程是唯一的消费者
+class BinaryLogRing : noncopyable
+{
+public:
+    static const size_t kSize = 1024 * 1024;    //2的幂
+    static const uint32_t kPadding = 0xFFFFFFFF; //环尾放不下一条记录时的填充标记
+
+    BinaryLogRing()
+        :   head_(0),
+            cachedTail_(0),
+            tail_(0),
+            abandoned_(false)
+    {}
+
+    //head_和tail_按cache line对齐 C++11的new不保证超过16字节的对齐 用create/destroy分配和释放
+    static BinaryLogRing* create();
+    static void destroy(BinaryLogRing *ring);
+
+    //生产者 预留len字节的连续空间  满了返回nullptr
+    char* reserve(size_t len);
+    void commit() { head_.store(reserveEnd_, std::memory_order_release); }
+
+    //消费者 把所有已提交的记录追加到out  返回是否取到了数据
+    bool drain(std::string *out);
+
+    //所属线程已退出 后端取完剩余的记录后释放
+    void abandon() { abandoned_.store(true, std::memory_order_release); }
+    bool abandoned() const { return abandoned_.load(std::memory_order_acquire); }
+
+    //记录按8字节对齐 环尾剩余的空间总能放下填充标记
+    static size_t align(size_t len) { return (len + 7) & ~static_cast<size_t>(7); }
+
+private:
+    char data_[kSize];
+
+    alignas(64) std::atomic<uint64_t> head_;
+    uint64_t cachedTail_;   //生产者缓存的tail_ 减少对消费者cache line的访问
+    uint64_t reserveEnd_;
+
+    alignas(64) std::atomic<uint64_t> tail_;
+    std::atomic_bool abandoned_;
+};
+
+class BinaryLogging : noncopyable
+{
+public:
+    static const uint32_t kVersion = 1;
+    static const uint32_t kDefinitionId = 0xFFFFFFFF;
+    //长度 格式ID 时间戳 tid
+    static const size_t kRecordHeaderSize = 4 + 4 + 8 + 4;
+
+    //开启后端线程 把日志写入filename
+    static bool start(const std::string &filename, int flushIntervalMs = 100);
+    //取走所有剩余的记录后关闭文件
+    static void stop();
+    static bool started() { return s_started_.load(std::memory_order_relaxed); }
+
+    //每个调用点执行一次 返回格式ID
+    static uint32_t registerFormat(int level, const char *file, int line,
+                                    const char *format, const char *signature);
+
+    //环形缓冲区满而被丢弃的日志条数
+    static uint64_t dropped() { return s_dropped_.load(std::memory_order_relaxed); }
+
+    template<typename... Args>
+    static void write(uint32_t formatId, const Args&... args)
+    {
+        if(!started())
+        {
+            return;
+        }
+        const size_t len = kRecordHeaderSize + argsSize(args...);
+        BinaryLogRing *ring = threadRing();
+        char *p = ring->reserve(len);
+        if(p == nullptr)
+        {
+            s_dropped_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        p = encodeHeader(p, static_cast<uint32_t>(len), formatId);
+        encodeArgs(p, args...);
+        ring->commit();
+    }
+
+    //只用于编译期推导参数类型和检查格式串 不会被调用
+    template<typename... Args>
+    static BinaryLogTypeList<typename std::decay<Args>::type...> typeList(Args&&...);
+    static void checkFormat(const char *format, ...) __attribute__((format(printf, 1, 2)));
+
+private:
+    static size_t argsSize() { return 0; }
+    template<typename T, typename... Rest>
+    static size_t argsSize(const T &first, const Rest&... rest)
+    {
+        return BinaryLogArg<typename std::decay<T>::type>::size(first) + argsSize(rest...);
+    }
+
+    static char* encodeArgs(char *p) { return p; }
+    template<typename T, typename... Rest>
+    static char* encodeArgs(char *p, const T &first, const Rest&... rest)
+    {
+        p = BinaryLogArg<typename std::decay<T>::type>::encode(p, first);
+        return encodeArgs(p, rest...);
+    }
+
+    static char* encodeHeader(char *p, uint32_t len, uint32_t formatId);
+    static BinaryLogRing* threadRing()
+    {
+        if(__builtin_expect(t_ring_ == nullptr, 0))
+        {
+            t_ring_ = createThreadRing();
+        }
+        return t_ring_;
+    }
+    static BinaryLogRing* createThreadRing();
+
+    static __thread BinaryLogRing *t_ring_;
+    static std::atomic_bool s_started_;
+    static std::atomic<uint64_t> s_dropped_;
+};
+
+inline void BinaryLogging::checkFormat(const char *, ...)
+{
+}
+
+//BLOG_INFO("%s %d", arg1, arg2)  和LOG_INFO用法相同 共用日志级别的过滤
+#define BLOG_LEVEL_IMPL(level, logmsgFormat, ...) \
+    do \
+    { \
+        if((level) >= MYMUDUO_MIN_LOG_LEVEL && Logger::isEnabled(level)) \
+        { \
+            if(false) \
+            { \
+                BinaryLogging::checkFormat(logmsgFormat, ##__VA_ARGS__); \
+            } \
+            static const uint32_t blogFormatId = BinaryLogging::registerFormat( \
+                level, __FILE__, __LINE__, logmsgFormat, \
+                BinaryLogSignature<decltype(BinaryLogging::typeList(__VA_ARGS__))>::value()); \
+            BinaryLogging::write(blogFormatId, ##__VA_ARGS__); \
+        } \
+    } while(0)
+
+#define BLOG_DEBUG(logmsgFormat, ...) BLOG_LEVEL_IMPL(DEBUG, logmsgFormat, ##__VA_ARGS__)
+#define BLOG_INFO(logmsgFormat, ...) BLOG_LEVEL_IMPL(INFO, logmsgFormat, ##__VA_ARGS__)
+#define BLOG_WARN(logmsgFormat, ...) BLOG_LEVEL_IMPL(WARN, logmsgFormat, ##__VA_ARGS__)
+#define BLOG_ERROR(logmsgFormat, ...) BLOG_LEVEL_IMPL(ERROR, logmsgFormat, ##__VA_ARGS__)
@@ -1,6 +1,11 @@
 #include "Buffer.h"
+#include "Logger.h"
 #include "errno.h"
+#include <string.h>
+#include <new>
+#include <sys/mman.h>
 #include <sys/uio.h>
+#include <unistd.h>
 
 
 //从fd上读取数据  poller 工作在 LT 模式
@@ -24,9 +29,229 @@ count参数是vector数组的长度，即有多少块内存需要从fd读出或
 两者调用成功时返回读出/写入fd的字节数，失败返回-1，并设置errno，此时需要引入error.h头文件。
 */
 
+const size_t Buffer::kMinReadHint;
+const size_t Buffer::kMaxReadHint;
+const int Buffer::kMaxVarintLength;
+
+char Buffer::s_emptyStorage[Buffer::kCheapPrepend];
+
+Buffer::Buffer(const Buffer &rhs)
+    :   buffer_(s_emptyStorage),
+        capacity_(kCheapPrepend),
+        readerIndex_(kCheapPrepend),
+        writerIndex_(kCheapPrepend),
+        initialSize_(rhs.initialSize_),
+        readHint_(rhs.readHint_),
+        ringSize_(0)
+{
+    if(rhs.ringSize_ != 0)
+    {
+        enableRing(rhs.ringSize_);
+    }
+    if(rhs.readableBytes() > 0)
+    {
+        append(rhs.peek(), rhs.readableBytes());
+    }
+}
+
+Buffer::Buffer(Buffer &&rhs)
+    :   buffer_(rhs.buffer_),
+        capacity_(rhs.capacity_),
+        readerIndex_(rhs.readerIndex_),
+        writerIndex_(rhs.writerIndex_),
+        initialSize_(rhs.initialSize_),
+        readHint_(rhs.readHint_),
+        ringSize_(rhs.ringSize_)
+{
+    rhs.buffer_ = s_emptyStorage;
+    rhs.capacity_ = kCheapPrepend;
+    rhs.ringSize_ = 0;
+    rhs.readerIndex_ = rhs.writerIndex_ = kCheapPrepend;
+}
+
+//从BufferPool取一块能放下 可读数据 + len 的存储 可读数据搬到新存储的kCheapPrepend处
+void Buffer::grow(size_t len)
+{
+    const size_t readable = readableBytes();
+    size_t size = kCheapPrepend + readable + std::max(len, initialSize_);
+    size_t capacity = 0;
+    BufferStorage *storage = BufferStorage::create(size, &capacity);
+    ::memcpy(storage->data() + kCheapPrepend, peek(), readable);
+    releaseStorage();
+    buffer_ = storage->data();
+    capacity_ = capacity;
+    readerIndex_ = kCheapPrepend;
+    writerIndex_ = readerIndex_ + readable;
+}
+
+bool Buffer::enableRing(size_t size)
+{
+    if(ringSize_ != 0 && size <= ringSize_)
+    {
+        return true;
+    }
+    //旧存储先留着 新ring映射成功后再把可读数据搬过去
+    char *oldBuffer = buffer_;
+    size_t oldCapacity = capacity_;
+    size_t oldRingSize = ringSize_;
+    const size_t readable = readableBytes();
+    const char *data = peek();
+    if(!mapRing(std::max(size, kCheapPrepend + readable)))
+    {
+        return false;
+    }
+    ::memcpy(buffer_ + kCheapPrepend, data, readable);
+    readerIndex_ = kCheapPrepend;
+    writerIndex_ = readerIndex_ + readable;
+    if(oldRingSize != 0)
+    {
+        ::munmap(oldBuffer, oldCapacity);
+    }
+    else if(oldBuffer != s_emptyStorage)
+    {
+        (reinterpret_cast<BufferStorage*>(oldBuffer) - 1)->release();
+    }
+    return true;
+}
+
+BufferSlice Buffer::retriveAsSlice(size_t len)
+{
+    len = std::min(len, readableBytes());
+    if(len == readableBytes())
+    {
+        return retriveAllAsSlice();
+    }
+    if(ringSize_ != 0)
+    {
+        //ring的空间会被循环覆盖 只能拷贝
+        BufferSlice slice(peek(), len);
+        retrive(len);
+        return slice;
+    }
+    BufferStorage *s = storage();
+    s->retain();
+    BufferSlice slice(s, peek(), len);
+    retrive(len);
+    return slice;
+}
+
+BufferSlice Buffer::retriveAllAsSlice()
+{
+    if(readableBytes() == 0)
+    {
+        return BufferSlice();
+    }
+    if(ringSize_ != 0)
+    {
+        BufferSlice slice(peek(), readableBytes());
+        retriveAll();
+        return slice;
+    }
+    //Buffer持有的引用直接转给slice
+    BufferSlice slice(storage(), peek(), readableBytes());
+    buffer_ = s_emptyStorage;
+    capacity_ = kCheapPrepend;
+    readerIndex_ = writerIndex_ = kCheapPrepend;
+    return slice;
+}
+
+void Buffer::appendStorage(BufferStorage *storage, size_t len)
+{
+    if(ringSize_ == 0 && readableBytes() == 0)
+    {
+        releaseStorage();
+        buffer_ = storage->data();
+        capacity_ = storage->blockSize - sizeof(BufferStorage);
+        readerIndex_ = kCheapPrepend;
+        writerIndex_ = readerIndex_ + len;
+        return;
+    }
+    append(storage->data() + kCheapPrepend, len);
+    storage->release();
+}
+
+void Buffer::growRing(size_t len)
+{
+    size_t size = ringSize_ * 2;
+    while(size < kCheapPrepend + readableBytes() + len)
+    {
+        size *= 2;
+    }
+    if(!enableRing(size))
+    {
+        throw std::bad_alloc();
+    }
+}
+
+bool Buffer::mapRing(size_t size)
+{
+    size_t ringSize = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+    while(ringSize < size)
+    {
+        ringSize *= 2;
+    }
+
+    int fd = ::memfd_create("mymuduo-buffer", MFD_CLOEXEC);
+    if(fd < 0)
+    {
+        LOG_ERROR("%s:%s:%d memfd_create err:%d \n", __FILE__, __FUNCTION__, __LINE__, errno);
+        return false;
+    }
+    if(::ftruncate(fd, ringSize) < 0)
+    {
+        LOG_ERROR("%s:%s:%d ftruncate err:%d \n", __FILE__, __FUNCTION__, __LINE__, errno);
+        ::close(fd);
+        return false;
+    }
+
+    //先占住2倍大小的地址空间 再把memfd固定映射到前后两半
+    char *base = static_cast<char*>(::mmap(NULL, 2 * ringSize, PROT_NONE,
+                                MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+    bool ok = base != MAP_FAILED;
+    if(ok)
+    {
+        ok = ::mmap(base, ringSize, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_FIXED, fd, 0) != MAP_FAILED
+          && ::mmap(base + ringSize, ringSize, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_FIXED, fd, 0) != MAP_FAILED;
+        if(!ok)
+        {
+            ::munmap(base, 2 * ringSize);
+        }
+    }
+    ::close(fd);    //映射会保持memfd的引用
+    if(!ok)
+    {
+        LOG_ERROR("%s:%s:%d mmap ring err:%d \n", __FILE__, __FUNCTION__, __LINE__, errno);
+        return false;
+    }
+
+    buffer_ = base;
+    capacity_ = 2 * ringSize;
+    ringSize_ = ringSize;
+    return true;
+}
+
+void Buffer::unmapRing()
+{
+    ::munmap(buffer_, capacity_);
+    buffer_ = s_emptyStorage;
+    capacity_ = kCheapPrepend;
+    ringSize_ = 0;
+}
+
+//每个线程一块64K的临时缓冲区 放在栈外 也不需要每次读之前清零
+static __thread char t_extrabuf[65536];
+
 ssize_t Buffer::readFd(int fd, int* saveErrno)
 {
-    char extrabuf[65536] = {0};//栈上内存 64k
+    //上一次读满了 说明是大量数据的传输 提前预留readHint_大小的可写空间 减少系统调用的次数
+    //小消息的连接readHint_保持在最小值 数据取走后存储就还给BufferPool 不会多占内存
+    //ring的大小由使用者决定 不跟着readHint_扩大
+    if(writableBytes() < readHint_ && ringSize_ == 0)
+    {
+        ensureWriteableBytes(readHint_);
+    }
 
     struct iovec vec[2];
 
@@ -34,10 +259,11 @@ ssize_t Buffer::readFd(int fd, int* saveErrno)
     vec[0].iov_base = begin() + writerIndex_;
     vec[0].iov_len = writable;
 
-    vec[1].iov_base = extrabuf;
-    vec[1].iov_len = sizeof extrabuf;
+    vec[1].iov_base = t_extrabuf;
+    vec[1].iov_len = sizeof t_extrabuf;
 
-    const int iovcnt = writable < sizeof extrabuf ? 2 : 1;
+    const int iovcnt = writable < sizeof t_extrabuf ? 2 : 1;
+    const size_t capacity = iovcnt == 2 ? writable + sizeof t_extrabuf : writable;
 
     const ssize_t n = ::readv(fd, vec, iovcnt);
     if(n < 0)
@@ -50,11 +276,40 @@ ssize_t Buffer::readFd(int fd, int* saveErrno)
     }
     else    //extrabuf也写入了数据
     {
-        writerIndex_ = buffer_.size();
+        writerIndex_ += writable;
         //将暂存在extrabuf中的数据append进Buffer的可写缓冲区中(扩容后)
-        append(extrabuf, n - writable);
+        append(t_extrabuf, n - writable);
+    }
+
+    //调整下一次的读取大小: 读满了就翻倍 连续读得很少就减半
+    if(n > 0)
+    {
+        size_t nread = static_cast<size_t>(n);
+        if(nread == capacity)
+        {
+            readHint_ = std::min(std::max(readHint_, nread) * 2, kMaxReadHint);
+        }
+        else if(nread < readHint_ / 4)
+        {
+            readHint_ = std::max(readHint_ / 2, kMinReadHint);
+        }
     }
 
     return n;
 
 }
+
+//把可读的数据写到fd 写成功的部分从缓冲区中取走
+ssize_t Buffer::writeFd(int fd, int* saveErrno)
+{
+    ssize_t n = ::write(fd, peek(), readableBytes());
+    if(n < 0)
+    {
+        *saveErrno = errno;
+    }
+    else
+    {
+        retrive(n);
+    }
+    return n;
+}
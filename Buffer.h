@@ -1,36 +1,125 @@
 #pragma once
 
-#include <vector>
+#include "BufferSlice.h"
+#include "ByteSearch.h"
+#include "StringPiece.h"
+
 #include <string>
 #include <algorithm>
+#include <endian.h>
+#include <assert.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/types.h>
 //网络库底层的缓冲区
+//存储从BufferPool中按需分配 第一次写入时才分配 数据被全部取走后归还给BufferPool
+//存储带引用计数(BufferStorage) 可以用BufferSlice不拷贝地取走数据
 /// @code
 /// +-------------------+------------------+------------------+
 /// | prependable bytes |  readable bytes  |  writable bytes  |
 /// |                   |     (CONTENT)    |                  |
 /// +-------------------+------------------+------------------+
 /// |                   |                  |                  |
-/// 0      <=      readerIndex   <=   writerIndex    <=     size
+/// 0      <=      readerIndex   <=   writerIndex    <=   capacity
+/// @endcode
+//
+//enableRing()后改用"magic ring": 同一块物理内存(memfd)在虚拟地址上连续映射两次
+//可读数据越过ring末尾时自然延续到第二份映射 peek()开始的数据总是连续的 也不需要makespace搬移
+/// @code
+/// |<------------- ringSize ------------->|<------------- ringSize ------------->|
+/// +--------------------------------------+--------------------------------------+
+/// |            mapping 1                 |    mapping 2 (同一块物理内存)          |
+/// +--------------------------------------+--------------------------------------+
+///        ^readerIndex            ^writerIndex  (writerIndex - readerIndex <= ringSize - kCheapPrepend)
 /// @endcode
+//readerIndex越过ringSize + kCheapPrepend后两个下标同时减去ringSize 始终保留kCheapPrepend的prependable空间
 class Buffer
 {
 public:
     static const size_t kCheapPrepend = 8;
     static const size_t kInitialSize = 1024;
+    //readFd自适应读取大小的上下限
+    static const size_t kMinReadHint = 1024;
+    static const size_t kMaxReadHint = 1024 * 1024;
 
     explicit Buffer(size_t initialSize = kInitialSize)
-        :   buffer_(kCheapPrepend + initialSize),
+        :   buffer_(s_emptyStorage),
+            capacity_(kCheapPrepend),
             readerIndex_(kCheapPrepend),
-            writerIndex_(kCheapPrepend)
+            writerIndex_(kCheapPrepend),
+            initialSize_(initialSize),
+            readHint_(kMinReadHint),
+            ringSize_(0)
     {}
+
+    ~Buffer()
+    {
+        releaseStorage();
+    }
+
+    Buffer(const Buffer &rhs);
+    Buffer(Buffer &&rhs);
+    Buffer& operator=(Buffer rhs)
+    {
+        swap(rhs);
+        return *this;
+    }
+
+    void swap(Buffer &rhs)
+    {
+        std::swap(buffer_, rhs.buffer_);
+        std::swap(capacity_, rhs.capacity_);
+        std::swap(readerIndex_, rhs.readerIndex_);
+        std::swap(writerIndex_, rhs.writerIndex_);
+        std::swap(initialSize_, rhs.initialSize_);
+        std::swap(readHint_, rhs.readHint_);
+        std::swap(ringSize_, rhs.ringSize_);
+    }
+
+    //改用magic ring存储 size向上取整为页大小的2的幂 已有的可读数据会搬过去
+    //memfd/mmap失败时返回false 继续使用普通存储
+    bool enableRing(size_t size);
+    bool isRing() const { return ringSize_ != 0; }
     
     size_t readableBytes() const    { return writerIndex_ - readerIndex_; }
-    size_t writableBytes() const    { return buffer_.size() -  writerIndex_; }
-    size_t prependableBytes() const { return readerIndex_; }
+    size_t writableBytes() const
+    {
+        return ringSize_ == 0 ? capacity_ -  writerIndex_
+                              : ringSize_ - kCheapPrepend - readableBytes();
+    }
+    //ring中readerIndex前面是上一圈的空间 只有保留的kCheapPrepend字节是空的
+    //prepend占用的是可写空间 可写的不够时也不能prepend
+    size_t prependableBytes() const
+    {
+        if(ringSize_ == 0)
+        {
+            return readerIndex_;
+        }
+        size_t n = std::min(readerIndex_, writableBytes());
+        return n < kCheapPrepend ? n : kCheapPrepend;
+    }
 
     //返回缓冲区中可读数据的起始地址
     const char* peek() const    { return begin() + readerIndex_; }
 
+    //在可读数据[peek() + offset, beginWrite())中查找 找不到返回nullptr
+    //offset相对peek() 半帧没找到时记下已扫描的位置(单字节为readableBytes() 两字节序列为readableBytes() - 1)
+    //数据到齐后从那里继续查找 不用重新扫描 中间retrive(len)过的话offset要减去len
+    const char* findByte(char c, size_t offset = 0) const
+    {
+        return offset > readableBytes() ? nullptr : ByteSearch::findByte(peek() + offset, beginWrite(), c);
+    }
+    const char* findPair(char c1, char c2, size_t offset = 0) const
+    {
+        return offset > readableBytes() ? nullptr : ByteSearch::findPair(peek() + offset, beginWrite(), c1, c2);
+    }
+    const char* findAnyOf(const char *set, size_t setLen, size_t offset = 0) const
+    {
+        return offset > readableBytes() ? nullptr : ByteSearch::findAnyOf(peek() + offset, beginWrite(), set, setLen);
+    }
+    const char* findCRLF(size_t offset = 0) const   { return findPair('\r', '\n', offset); }
+    const char* findEOL(size_t offset = 0) const    { return findByte('\n', offset); }
+
     //
     void retrive(size_t len)
     {
@@ -38,6 +127,12 @@ public:
         {
             //只读取了可读缓冲区数据的一部分(len) 还剩readerIndex_ += len -- writerIndex_没读
             readerIndex_ += len;  
+            if(readerIndex_ >= ringSize_ + kCheapPrepend && ringSize_ != 0)
+            {
+                //ring的读位置进入第二份映射 回绕到第一份
+                readerIndex_ -= ringSize_;
+                writerIndex_ -= ringSize_;
+            }
         }
         else    //len == readableBytes()
         {
@@ -46,10 +141,18 @@ public:
 
     }
 
+    //数据全部取走 存储还给BufferPool 空闲的连接不占用缓冲区(ring保留映射)
     void retriveAll()
     {
+        if(ringSize_ == 0)
+        {
+            releaseStorage();
+        }
         readerIndex_ = writerIndex_ = kCheapPrepend;
     }
+
+    //底层存储的大小 没有分配时为kCheapPrepend
+    size_t capacity() const { return ringSize_ == 0 ? capacity_ : ringSize_; }
     
     //把onMessage函数上报的Buffer数据 ==> string 类型 
     std::string retriveAllAsString()
@@ -66,6 +169,14 @@ public:
         return result;
     }
 
+    //可读数据的视图 不拷贝 在下一次修改Buffer之前有效(onMessage回调内使用)
+    StringPiece toStringPiece() const   { return StringPiece(peek(), readableBytes()); }
+
+    //取走len字节 返回引用同一块存储的slice 不拷贝(ring存储会拷贝一份)
+    BufferSlice retriveAsSlice(size_t len);
+    //取走全部数据 整块存储直接交给返回的slice Buffer回到没有存储的状态
+    BufferSlice retriveAllAsSlice();
+
     void ensureWriteableBytes(size_t len)
     {
         if(writableBytes() < len)
@@ -82,19 +193,207 @@ public:
         writerIndex_ += len;
     }
 
+    void append(const void *data, size_t len)
+    {
+        append(static_cast<const char*>(data), len);
+    }
+
+    //追加storage中data() + kCheapPrepend开始的len字节 接管调用者持有的引用
+    //Buffer为空时直接换成这块存储 不拷贝(io_uring完成模式收到的数据块)
+    void appendStorage(BufferStorage *storage, size_t len);
+
     char* beginWrite()  { return begin() + writerIndex_; }
     const char* beginWrite() const  { return begin() + writerIndex_; }
+
+    //直接向beginWrite()写入了len字节后调用
+    void hasWritten(size_t len) { writerIndex_ += len; }
+
+    //定长整数 不带后缀的是网络字节序(大端) LE后缀的是小端
+    //peek/read之前调用者要保证readableBytes()足够
+    void appendInt64(int64_t x)     { uint64_t be = htobe64(x); append(&be, sizeof be); }
+    void appendInt32(int32_t x)     { uint32_t be = htobe32(x); append(&be, sizeof be); }
+    void appendInt16(int16_t x)     { uint16_t be = htobe16(x); append(&be, sizeof be); }
+    void appendInt8(int8_t x)       { append(&x, sizeof x); }
+    void appendInt64LE(int64_t x)   { uint64_t le = htole64(x); append(&le, sizeof le); }
+    void appendInt32LE(int32_t x)   { uint32_t le = htole32(x); append(&le, sizeof le); }
+    void appendInt16LE(int16_t x)   { uint16_t le = htole16(x); append(&le, sizeof le); }
+
+    int64_t peekInt64() const   { return static_cast<int64_t>(be64toh(peekRaw<uint64_t>())); }
+    int32_t peekInt32() const   { return static_cast<int32_t>(be32toh(peekRaw<uint32_t>())); }
+    int16_t peekInt16() const   { return static_cast<int16_t>(be16toh(peekRaw<uint16_t>())); }
+    int8_t peekInt8() const     { return static_cast<int8_t>(*peek()); }
+    int64_t peekInt64LE() const { return static_cast<int64_t>(le64toh(peekRaw<uint64_t>())); }
+    int32_t peekInt32LE() const { return static_cast<int32_t>(le32toh(peekRaw<uint32_t>())); }
+    int16_t peekInt16LE() const { return static_cast<int16_t>(le16toh(peekRaw<uint16_t>())); }
+
+    int64_t readInt64()     { int64_t x = peekInt64(); retrive(sizeof x); return x; }
+    int32_t readInt32()     { int32_t x = peekInt32(); retrive(sizeof x); return x; }
+    int16_t readInt16()     { int16_t x = peekInt16(); retrive(sizeof x); return x; }
+    int8_t readInt8()       { int8_t x = peekInt8(); retrive(sizeof x); return x; }
+    int64_t readInt64LE()   { int64_t x = peekInt64LE(); retrive(sizeof x); return x; }
+    int32_t readInt32LE()   { int32_t x = peekInt32LE(); retrive(sizeof x); return x; }
+    int16_t readInt16LE()   { int16_t x = peekInt16LE(); retrive(sizeof x); return x; }
+
+    //写到可读数据的前面 占用prependable区域 len不能超过prependableBytes()
+    //消息体写完之后再在前面补上长度头 不需要额外的临时缓冲区
+    void prepend(const void *data, size_t len)
+    {
+        //还没有存储 或者前面的空间可能还属于某个BufferSlice 先换到自己独占的存储
+        if(ringSize_ == 0 && (buffer_ == s_emptyStorage || storage()->shared()))
+        {
+            grow(0);
+        }
+        assert(len <= prependableBytes());
+        readerIndex_ -= len;
+        ::memcpy(begin() + readerIndex_, data, len);
+    }
+    void prependInt64(int64_t x)    { uint64_t be = htobe64(x); prepend(&be, sizeof be); }
+    void prependInt32(int32_t x)    { uint32_t be = htobe32(x); prepend(&be, sizeof be); }
+    void prependInt16(int16_t x)    { uint16_t be = htobe16(x); prepend(&be, sizeof be); }
+    void prependInt8(int8_t x)      { prepend(&x, sizeof x); }
+    void prependInt64LE(int64_t x)  { uint64_t le = htole64(x); prepend(&le, sizeof le); }
+    void prependInt32LE(int32_t x)  { uint32_t le = htole32(x); prepend(&le, sizeof le); }
+    void prependInt16LE(int16_t x)  { uint16_t le = htole16(x); prepend(&le, sizeof le); }
+
+    //LEB128无符号变长整数 每字节7位 最高位表示后面还有字节 64位最多10字节
+    static const int kMaxVarintLength = 10;
+
+    void appendVarint(uint64_t x)
+    {
+        char buf[kMaxVarintLength];
+        append(buf, encodeVarint(x, buf));
+    }
+
+    //返回varint占用的字节数 数据不完整返回0 超过10字节(非法)返回-1
+    int peekVarint(uint64_t *value) const
+    {
+        return decodeVarint(peek(), peek() + readableBytes(), value);
+    }
+    int readVarint(uint64_t *value)
+    {
+        int n = peekVarint(value);
+        if(n > 0)
+        {
+            retrive(n);
+        }
+        return n;
+    }
+
+    static int encodeVarint(uint64_t x, char *out)
+    {
+        int n = 0;
+        while(x >= 0x80)
+        {
+            out[n++] = static_cast<char>(x | 0x80);
+            x >>= 7;
+        }
+        out[n++] = static_cast<char>(x);
+        return n;
+    }
+
+    static int decodeVarint(const char *p, const char *end, uint64_t *value)
+    {
+        uint64_t result = 0;
+        for(int i = 0; i < kMaxVarintLength; ++i)
+        {
+            if(p + i == end)
+            {
+                return 0;
+            }
+            uint8_t byte = static_cast<uint8_t>(p[i]);
+            result |= static_cast<uint64_t>(byte & 0x7f) << (7 * i);
+            if((byte & 0x80) == 0)
+            {
+                *value = result;
+                return i + 1;
+            }
+        }
+        return -1;
+    }
+
+    //帧的长度头格式
+    enum LengthPrefix
+    {
+        kPrefixInt32,   //4字节大端
+        kPrefixInt32LE, //4字节小端
+        kPrefixVarint,  //LEB128
+    };
+
+    //一遍扫描取出所有完整的 长度头 + body 帧 对每一帧调用onFrame(const char *body, size_t len)
+    //只在最后retrive一次 剩下的半帧留在Buffer中  onFrame里不能修改这个Buffer
+    //返回取出的帧数  长度超过maxFrameLength或者varint非法时返回-1 之前的帧已经取走 连接应该关闭
+    template<typename FrameFunc>
+    ssize_t retriveFrames(LengthPrefix prefix, size_t maxFrameLength, FrameFunc &&onFrame)
+    {
+        const char *p = peek();
+        const char *end = beginWrite();
+        ssize_t frames = 0;
+        while(p < end)
+        {
+            uint64_t len = 0;
+            int header = 0;
+            if(prefix == kPrefixVarint)
+            {
+                header = decodeVarint(p, end, &len);
+            }
+            else if(end - p >= 4)
+            {
+                uint32_t raw;
+                ::memcpy(&raw, p, sizeof raw);
+                len = prefix == kPrefixInt32 ? be32toh(raw) : le32toh(raw);
+                header = 4;
+            }
+            if(header < 0 || len > maxFrameLength)
+            {
+                frames = -1;
+                break;
+            }
+            if(header == 0 || static_cast<uint64_t>(end - p - header) < len)
+            {
+                break;  //半帧
+            }
+            onFrame(p + header, static_cast<size_t>(len));
+            p += header + len;
+            ++frames;
+        }
+        retrive(p - peek());
+        return frames;
+    }
     
     //从fd上读取数据
     ssize_t readFd(int fd, int* saveError);
-    //从fd上fasong数据
+    //向fd发送数据 发送成功的部分从缓冲区中取走
     ssize_t writeFd(int fd, int* saveError);
 
 
 private:
-    //1. it.begin() vector首元素的迭代器  2.it.operator*() 取值运算符重载 首元素 3. & 取址
-    char* begin()   { return &*buffer_.begin(); }
-    const char* begin() const  { return &*buffer_.begin(); }
+    char* begin()   { return buffer_; }
+    const char* begin() const  { return buffer_; }
+
+    template<typename T>
+    T peekRaw() const
+    {
+        T x;
+        ::memcpy(&x, peek(), sizeof x);
+        return x;
+    }
+
+    //普通存储的头部 在buffer_前面
+    BufferStorage* storage() const  { return reinterpret_cast<BufferStorage*>(buffer_) - 1; }
+
+    void releaseStorage()
+    {
+        if(ringSize_ != 0)
+        {
+            unmapRing();
+        }
+        else if(buffer_ != s_emptyStorage)
+        {
+            storage()->release();
+            buffer_ = s_emptyStorage;
+            capacity_ = kCheapPrepend;
+        }
+    }
 
     void makespace(size_t len)
     {
@@ -103,23 +402,30 @@ private:
 /// |                   |     (CONTENT)    |                  |
 /// +-------------------+------------------+------------------+
 /// |----------------------------|         |------------------|
-/// 0                    <=  readerIndex <= writerIndex       <=size
+/// 0                    <=  readerIndex <= writerIndex       <=capacity
 
 /// |-------------------|-------------------------------------------|
 ///                kCheapPrepend                                   len
 
+        if(ringSize_ != 0)
+        {
+            //ring的可写空间已经是剩余的全部 只能换一个更大的ring
+            growRing(len);
+        }
         // 真正可写的内存大小 + read区域前面空闲出来的大小 < 需要写的大小 + kCheapPrepend
-        if(writableBytes() + prependableBytes() < len + kCheapPrepend)
+        // 或者存储被BufferSlice引用着 不能移动数据覆盖slice
+        else if(writableBytes() + prependableBytes() < len + kCheapPrepend
+                || (buffer_ != s_emptyStorage && storage()->shared()))
         {
-            buffer_.resize(writerIndex_ + len);//直接扩容
+            grow(len);//换一块更大的存储
         }
         else    //把还未读的数据移动到前面
         {
 /// | prependable bytes |  readable bytes    |  writable bytes  |
 /// |----------------------------| readable  |------------------|
-/// 0                    <=  readerIndex <= writerIndex    <=size
+/// 0                    <=  readerIndex <= writerIndex    <=capacity
 /// |-------------------| readable  |---------------------------|
-/// 0         <=  readerIndex <= writerIndex               <=size
+/// 0         <=  readerIndex <= writerIndex               <=capacity
             size_t readable = readableBytes();
             std::copy(begin() + readerIndex_,
                     begin() + writerIndex_,
@@ -131,9 +437,25 @@ private:
 
 
     }
-    
-    std::vector<char> buffer_;
+
+    void grow(size_t len);
+    void growRing(size_t len);
+    //映射一个size字节的ring 成功后buffer_/capacity_/ringSize_指向新的ring
+    bool mapRing(size_t size);
+    void unmapRing();
+
+    //还没有分配存储的Buffer都指向它 可写空间为0
+    static char s_emptyStorage[kCheapPrepend];
+
+    char *buffer_;
+    size_t capacity_;
     size_t readerIndex_;
     size_t writerIndex_;
+    //第一次分配存储时的最小可写空间
+    size_t initialSize_;
+    //根据最近几次读取的大小估计下一次要读多少
+    size_t readHint_;
+    //magic ring的大小 0表示普通存储
+    size_t ringSize_;
 };
 
@@ -0,0 +1,282 @@
+#include "BufferPool.h"
+
+#include <atomic>
+#include <mutex>
+#include <stdlib.h>
+#include <stdint.h>
+#include <sys/mman.h>
+
+const size_t BufferPool::kMinBlockShift;
+const size_t BufferPool::kMaxBlockShift;
+const size_t BufferPool::kNumClasses;
+const size_t BufferPool::kMinBlockSize;
+const size_t BufferPool::kMaxBlockSize;
+const size_t BufferPool::kSlabSize;
+
+namespace
+{
+
+struct FreeBlock
+{
+    FreeBlock *next;
+};
+
+std::atomic<int> g_hugePageMode(BufferPool::kNoHugePages);
+std::atomic<size_t> g_slabBytes(0);
+
+//线程退出时留下的空闲块 以及各线程空闲链表超过上限时溢出的块
+std::mutex g_mutex;
+FreeBlock *g_freeLists[BufferPool::kNumClasses];
+
+//每个线程每个等级最多缓存的空闲块 超过后把一半交给全局链表
+//一个线程分配另一个线程释放时(跨线程send 完成模式的接收块) 块才能回到分配的线程 不会一直切新的slab
+size_t maxCachedBlocks(size_t index)
+{
+    size_t blocks = BufferPool::kSlabSize / (BufferPool::kMinBlockSize << index);
+    return blocks > 2 ? blocks : 2;
+}
+
+size_t classIndex(size_t size)
+{
+    if(size <= BufferPool::kMinBlockSize)
+    {
+        return 0;
+    }
+    //向上取整到2的幂
+    size_t shift = 64 - __builtin_clzll(static_cast<unsigned long long>(size - 1));
+    return shift - BufferPool::kMinBlockShift;
+}
+
+char* mapSlab(size_t size)
+{
+    int mode = g_hugePageMode.load(std::memory_order_relaxed);
+    void *addr = MAP_FAILED;
+    if(mode == BufferPool::kHugeTLB)
+    {
+        addr = ::mmap(NULL, size, PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    }
+    else if(mode == BufferPool::kTransparentHugePages)
+    {
+        //多映射一个大页的大小 裁剪出2M对齐的区间 THP才能生效
+        const size_t align = BufferPool::kSlabSize;
+        void *raw = ::mmap(NULL, size + align, PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if(raw != MAP_FAILED)
+        {
+            uintptr_t begin = reinterpret_cast<uintptr_t>(raw);
+            uintptr_t aligned = (begin + align - 1) & ~(align - 1);
+            if(aligned > begin)
+            {
+                ::munmap(raw, aligned - begin);
+            }
+            uintptr_t end = begin + size + align;
+            if(end > aligned + size)
+            {
+                ::munmap(reinterpret_cast<void*>(aligned + size), end - aligned - size);
+            }
+            addr = reinterpret_cast<void*>(aligned);
+            ::madvise(addr, size, MADV_HUGEPAGE);
+        }
+    }
+    if(addr == MAP_FAILED)
+    {
+        addr = ::mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if(addr == MAP_FAILED)
+        {
+            return nullptr;
+        }
+    }
+    g_slabBytes.fetch_add(size, std::memory_order_relaxed);
+    return static_cast<char*>(addr);
+}
+
+__thread bool t_cacheDestroyed = false;
+
+class ThreadCache
+{
+public:
+    ThreadCache()
+    {
+        for(size_t i = 0; i < BufferPool::kNumClasses; ++i)
+        {
+            freeLists_[i] = nullptr;
+            freeCounts_[i] = 0;
+            slabCursor_[i] = nullptr;
+            slabEnd_[i] = nullptr;
+        }
+    }
+
+    //线程退出 空闲块和slab中还没切分的部分都交给全局链表
+    ~ThreadCache()
+    {
+        t_cacheDestroyed = true;
+        std::unique_lock<std::mutex> lock(g_mutex);
+        for(size_t i = 0; i < BufferPool::kNumClasses; ++i)
+        {
+            const size_t blockSize = BufferPool::kMinBlockSize << i;
+            while(slabCursor_[i] != slabEnd_[i])
+            {
+                push(&freeLists_[i], slabCursor_[i]);
+                slabCursor_[i] += blockSize;
+            }
+            while(freeLists_[i] != nullptr)
+            {
+                FreeBlock *block = freeLists_[i];
+                freeLists_[i] = block->next;
+                block->next = g_freeLists[i];
+                g_freeLists[i] = block;
+            }
+        }
+    }
+
+    char* allocate(size_t index)
+    {
+        FreeBlock *block = freeLists_[index];
+        if(block != nullptr)
+        {
+            freeLists_[index] = block->next;
+            --freeCounts_[index];
+            return reinterpret_cast<char*>(block);
+        }
+        return refill(index);
+    }
+
+    void deallocate(char *p, size_t index)
+    {
+        push(&freeLists_[index], p);
+        if(++freeCounts_[index] > maxCachedBlocks(index))
+        {
+            spill(index);
+        }
+    }
+
+private:
+    static void push(FreeBlock **list, char *p)
+    {
+        FreeBlock *block = reinterpret_cast<FreeBlock*>(p);
+        block->next = *list;
+        *list = block;
+    }
+
+    //留下一半 其余一次加锁交给全局链表
+    void spill(size_t index)
+    {
+        const size_t keep = maxCachedBlocks(index) / 2;
+        FreeBlock *first = freeLists_[index];
+        FreeBlock *last = first;
+        size_t n = 1;
+        for(; n < freeCounts_[index] - keep; ++n)
+        {
+            last = last->next;
+        }
+        freeLists_[index] = last->next;
+        freeCounts_[index] = keep;
+
+        std::unique_lock<std::mutex> lock(g_mutex);
+        last->next = g_freeLists[index];
+        g_freeLists[index] = first;
+    }
+
+    char* refill(size_t index)
+    {
+        const size_t blockSize = BufferPool::kMinBlockSize << index;
+        if(slabCursor_[index] == slabEnd_[index])
+        {
+            //先看全局链表中其他线程留下的块 一次最多取半个上限
+            {
+                std::unique_lock<std::mutex> lock(g_mutex);
+                if(g_freeLists[index] != nullptr)
+                {
+                    FreeBlock *block = g_freeLists[index];
+                    FreeBlock *last = block;
+                    size_t n = 0;
+                    const size_t batch = maxCachedBlocks(index) / 2;
+                    while(n < batch && last->next != nullptr)
+                    {
+                        last = last->next;
+                        ++n;
+                    }
+                    g_freeLists[index] = last->next;
+                    last->next = nullptr;
+                    freeLists_[index] = block->next;
+                    freeCounts_[index] = n;
+                    return reinterpret_cast<char*>(block);
+                }
+            }
+            size_t slabSize = blockSize > BufferPool::kSlabSize ? blockSize : BufferPool::kSlabSize;
+            char *slab = mapSlab(slabSize);
+            if(slab == nullptr)
+            {
+                return nullptr;
+            }
+            slabCursor_[index] = slab;
+            slabEnd_[index] = slab + slabSize;
+        }
+        char *p = slabCursor_[index];
+        slabCursor_[index] += blockSize;
+        return p;
+    }
+
+    FreeBlock *freeLists_[BufferPool::kNumClasses];
+    size_t freeCounts_[BufferPool::kNumClasses];
+    char *slabCursor_[BufferPool::kNumClasses];
+    char *slabEnd_[BufferPool::kNumClasses];
+};
+
+thread_local ThreadCache t_cache;
+
+//本线程的缓存已经析构(线程退出过程中析构的Buffer) 改用加锁的共享缓存 不再析构
+std::mutex g_sharedMutex;
+ThreadCache *g_sharedCache = new ThreadCache;
+
+} // namespace
+
+void BufferPool::setHugePageMode(HugePageMode mode)
+{
+    g_hugePageMode.store(mode, std::memory_order_relaxed);
+}
+
+char* BufferPool::allocate(size_t size, size_t *actualSize)
+{
+    if(size > kMaxBlockSize)
+    {
+        //同样按2的幂取整 Buffer扩容时才是成倍增长
+        size_t actual = kMaxBlockSize;
+        while(actual < size)
+        {
+            actual *= 2;
+        }
+        *actualSize = actual;
+        return static_cast<char*>(::malloc(actual));
+    }
+    size_t index = classIndex(size);
+    *actualSize = kMinBlockSize << index;
+    if(t_cacheDestroyed)
+    {
+        std::unique_lock<std::mutex> lock(g_sharedMutex);
+        return g_sharedCache->allocate(index);
+    }
+    return t_cache.allocate(index);
+}
+
+void BufferPool::deallocate(char *block, size_t actualSize)
+{
+    if(actualSize > kMaxBlockSize)
+    {
+        ::free(block);
+        return;
+    }
+    if(t_cacheDestroyed)
+    {
+        std::unique_lock<std::mutex> lock(g_sharedMutex);
+        g_sharedCache->deallocate(block, classIndex(actualSize));
+        return;
+    }
+    t_cache.deallocate(block, classIndex(actualSize));
+}
+
+size_t BufferPool::slabBytes()
+{
+    return g_slabBytes.load(std::memory_order_relaxed);
+}
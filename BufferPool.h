@@ -0,0 +1,42 @@
+#pragma once
+
+#include "noncopyable.h"
+
+#include <stddef.h>
+
+/*
+Buffer底层存储的内存池  按2的幂划分大小等级
+    每个线程(one loop per thread 即每个loop)有自己的空闲链表 分配和释放都不加锁
+    空闲链表为空时从本线程的slab中切分  slab一次向系统申请kSlabSize 可选用大页
+    每个等级的空闲链表最多缓存约kSlabSize字节 超过后溢出到全局链表 线程退出时也交给全局链表
+    其他线程缺块时先从全局链表取 跨线程释放的块由此回到分配它的线程
+    超过kMaxBlockSize的请求(同样取整到2的幂)直接使用malloc/free
+块从slab中切出后不会还给系统 池的大小等于各个等级使用的峰值
+*/
+class BufferPool : noncopyable
+{
+public:
+    enum HugePageMode
+    {
+        kNoHugePages,           //普通4K页
+        kTransparentHugePages,  //slab按2M对齐 madvise(MADV_HUGEPAGE)
+        kHugeTLB,               //MAP_HUGETLB 需要预留大页 失败时退回普通页
+    };
+
+    static const size_t kMinBlockShift = 10;    //1K
+    static const size_t kMaxBlockShift = 22;    //4M
+    static const size_t kNumClasses = kMaxBlockShift - kMinBlockShift + 1;
+    static const size_t kMinBlockSize = static_cast<size_t>(1) << kMinBlockShift;
+    static const size_t kMaxBlockSize = static_cast<size_t>(1) << kMaxBlockShift;
+    static const size_t kSlabSize = 2 * 1024 * 1024;
+
+    //在第一次分配之前设置
+    static void setHugePageMode(HugePageMode mode);
+
+    //分配至少size字节 *actualSize返回实际大小(释放时传回)
+    static char* allocate(size_t size, size_t *actualSize);
+    static void deallocate(char *block, size_t actualSize);
+
+    //所有slab占用的字节数
+    static size_t slabBytes();
+};
@@ -0,0 +1,40 @@
+#include "BufferSlice.h"
+#include "BufferPool.h"
+
+#include <new>
+
+BufferStorage* BufferStorage::create(size_t dataSize, size_t *capacity)
+{
+    size_t blockSize = 0;
+    char *block = BufferPool::allocate(sizeof(BufferStorage) + dataSize, &blockSize);
+    if(block == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    BufferStorage *storage = reinterpret_cast<BufferStorage*>(block);
+    new (&storage->refCount) std::atomic<int>(1);
+    storage->blockSize = blockSize;
+    *capacity = blockSize - sizeof(BufferStorage);
+    return storage;
+}
+
+void BufferStorage::release()
+{
+    if(refCount.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    {
+        BufferPool::deallocate(reinterpret_cast<char*>(this), blockSize);
+    }
+}
+
+BufferSlice::BufferSlice(const char *data, size_t len)
+    :   storage_(nullptr), data_(nullptr), len_(0)
+{
+    if(len > 0)
+    {
+        size_t capacity = 0;
+        storage_ = BufferStorage::create(len, &capacity);
+        ::memcpy(storage_->data(), data, len);
+        data_ = storage_->data();
+        len_ = len;
+    }
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include "StringPiece.h"
+
+#include <atomic>
+#include <string>
+#include <utility>
+
+//Buffer底层存储块的头部 后面紧跟着数据区
+//Buffer自己持有一个引用 每个BufferSlice持有一个引用 最后一个释放的把块还给BufferPool
+struct BufferStorage
+{
+    std::atomic<int> refCount;
+    size_t blockSize;   //整个块的大小(包括头部) 释放时交给BufferPool
+
+    //分配一个数据区至少dataSize字节的块 引用计数为1 *capacity返回数据区的实际大小
+    static BufferStorage* create(size_t dataSize, size_t *capacity);
+
+    char* data()    { return reinterpret_cast<char*>(this + 1); }
+
+    void retain()   { refCount.fetch_add(1, std::memory_order_relaxed); }
+    void release();
+    //除了调用者还有别人引用这个块
+    bool shared() const { return refCount.load(std::memory_order_acquire) > 1; }
+};
+
+//引用Buffer底层存储中的一段数据 不拷贝 可以在onMessage回调返回之后继续持有 也可以交给其他线程
+//slice存在期间这段数据不会被Buffer覆盖或释放(Buffer需要整理空间时会换一块新的存储)
+class BufferSlice
+{
+public:
+    BufferSlice()
+        :   storage_(nullptr), data_(nullptr), len_(0)
+    {}
+    //拷贝一份数据到新的存储块中
+    BufferSlice(const char *data, size_t len);
+    ~BufferSlice()
+    {
+        reset();
+    }
+
+    BufferSlice(const BufferSlice &rhs)
+        :   storage_(rhs.storage_), data_(rhs.data_), len_(rhs.len_)
+    {
+        if(storage_ != nullptr)
+        {
+            storage_->retain();
+        }
+    }
+    BufferSlice(BufferSlice &&rhs) noexcept
+        :   storage_(rhs.storage_), data_(rhs.data_), len_(rhs.len_)
+    {
+        rhs.storage_ = nullptr;
+        rhs.data_ = nullptr;
+        rhs.len_ = 0;
+    }
+    BufferSlice& operator=(BufferSlice rhs)
+    {
+        swap(rhs);
+        return *this;
+    }
+
+    void swap(BufferSlice &rhs) noexcept
+    {
+        std::swap(storage_, rhs.storage_);
+        std::swap(data_, rhs.data_);
+        std::swap(len_, rhs.len_);
+    }
+
+    const char* data() const    { return data_; }
+    size_t size() const { return len_; }
+    bool empty() const  { return len_ == 0; }
+
+    StringPiece toStringPiece() const   { return StringPiece(data_, len_); }
+    std::string toString() const    { return std::string(data_, len_); }
+
+    void reset()
+    {
+        if(storage_ != nullptr)
+        {
+            storage_->release();
+            storage_ = nullptr;
+        }
+        data_ = nullptr;
+        len_ = 0;
+    }
+
+private:
+    friend class Buffer;
+
+    //接管调用者持有的一个storage引用
+    BufferSlice(BufferStorage *storage, const char *data, size_t len)
+        :   storage_(storage), data_(data), len_(len)
+    {}
+
+    BufferStorage *storage_;
+    const char *data_;
+    size_t len_;
+};
@@ -0,0 +1,215 @@
+#include "ByteSearch.h"
+
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define MYMUDUO_X86_SIMD 1
+#endif
+
+const size_t ByteSearch::kMaxSetSize;
+
+namespace
+{
+
+using FindPairFunc = const char* (*)(const char*, const char*, char, char);
+using FindAnyOfFunc = const char* (*)(const char*, const char*, const char*, size_t);
+
+struct Implementation
+{
+    FindPairFunc findPair;
+    FindAnyOfFunc findAnyOf;
+    const char *name;
+};
+
+//标量实现 也用来处理向量循环剩下的尾部
+const char* findByteScalar(const char *begin, const char *end, char c)
+{
+    return static_cast<const char*>(::memchr(begin, c, end - begin));
+}
+
+const char* findPairScalar(const char *begin, const char *end, char c1, char c2)
+{
+    const char *p = begin;
+    while(end - p >= 2)
+    {
+        p = static_cast<const char*>(::memchr(p, c1, end - p - 1));
+        if(p == nullptr)
+        {
+            return nullptr;
+        }
+        if(p[1] == c2)
+        {
+            return p;
+        }
+        ++p;
+    }
+    return nullptr;
+}
+
+const char* findAnyOfScalar(const char *begin, const char *end, const char *set, size_t setLen)
+{
+    bool table[256] = {false};
+    for(size_t i = 0; i < setLen; ++i)
+    {
+        table[static_cast<unsigned char>(set[i])] = true;
+    }
+    for(const char *p = begin; p < end; ++p)
+    {
+        if(table[static_cast<unsigned char>(*p)])
+        {
+            return p;
+        }
+    }
+    return nullptr;
+}
+
+#ifdef MYMUDUO_X86_SIMD
+
+//第二个字节用错开一位的load比较 两个结果相与
+const char* findPairSse2(const char *begin, const char *end, char c1, char c2)
+{
+    const __m128i first = _mm_set1_epi8(c1);
+    const __m128i second = _mm_set1_epi8(c2);
+    const char *p = begin;
+    for(; end - p >= 17; p += 16)
+    {
+        __m128i v0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        __m128i v1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 1));
+        int mask = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(v0, first),
+                                                   _mm_cmpeq_epi8(v1, second)));
+        if(mask != 0)
+        {
+            return p + __builtin_ctz(mask);
+        }
+    }
+    return findPairScalar(p, end, c1, c2);
+}
+
+const char* findAnyOfSse2(const char *begin, const char *end, const char *set, size_t setLen)
+{
+    __m128i needles[ByteSearch::kMaxSetSize];
+    for(size_t i = 0; i < setLen; ++i)
+    {
+        needles[i] = _mm_set1_epi8(set[i]);
+    }
+    const char *p = begin;
+    for(; end - p >= 16; p += 16)
+    {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        __m128i hit = _mm_setzero_si128();
+        for(size_t i = 0; i < setLen; ++i)
+        {
+            hit = _mm_or_si128(hit, _mm_cmpeq_epi8(v, needles[i]));
+        }
+        int mask = _mm_movemask_epi8(hit);
+        if(mask != 0)
+        {
+            return p + __builtin_ctz(mask);
+        }
+    }
+    return findAnyOfScalar(p, end, set, setLen);
+}
+
+__attribute__((target("avx2")))
+const char* findPairAvx2(const char *begin, const char *end, char c1, char c2)
+{
+    const __m256i first = _mm256_set1_epi8(c1);
+    const __m256i second = _mm256_set1_epi8(c2);
+    const char *p = begin;
+    for(; end - p >= 33; p += 32)
+    {
+        __m256i v0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        __m256i v1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 1));
+        unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(
+                _mm256_and_si256(_mm256_cmpeq_epi8(v0, first), _mm256_cmpeq_epi8(v1, second))));
+        if(mask != 0)
+        {
+            return p + __builtin_ctz(mask);
+        }
+    }
+    return findPairSse2(p, end, c1, c2);
+}
+
+__attribute__((target("avx2")))
+const char* findAnyOfAvx2(const char *begin, const char *end, const char *set, size_t setLen)
+{
+    __m256i needles[ByteSearch::kMaxSetSize];
+    for(size_t i = 0; i < setLen; ++i)
+    {
+        needles[i] = _mm256_set1_epi8(set[i]);
+    }
+    const char *p = begin;
+    for(; end - p >= 32; p += 32)
+    {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        __m256i hit = _mm256_setzero_si256();
+        for(size_t i = 0; i < setLen; ++i)
+        {
+            hit = _mm256_or_si256(hit, _mm256_cmpeq_epi8(v, needles[i]));
+        }
+        unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(hit));
+        if(mask != 0)
+        {
+            return p + __builtin_ctz(mask);
+        }
+    }
+    return findAnyOfSse2(p, end, set, setLen);
+}
+
+bool hasAvx2()
+{
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+}
+
+//第一次调用时选择一次 之后只是一次初始化标志的检查加一次间接跳转
+//不用全局变量: 其他编译单元的静态初始化(比如全局的Buffer或Logger)中调用时 全局变量可能还没有初始化
+const Implementation& selected()
+{
+    static const Implementation impl = hasAvx2()
+        ? Implementation{ findPairAvx2, findAnyOfAvx2, "avx2" }
+        : Implementation{ findPairSse2, findAnyOfSse2, "sse2" };
+    return impl;
+}
+
+#else
+
+const Implementation& selected()
+{
+    static const Implementation impl = { findPairScalar, findAnyOfScalar, "scalar" };
+    return impl;
+}
+
+#endif
+
+} // namespace
+
+//glibc的memchr已经按CPU选择了展开的SIMD实现 单字节直接使用它
+const char* ByteSearch::findByte(const char *begin, const char *end, char c)
+{
+    return findByteScalar(begin, end, c);
+}
+
+const char* ByteSearch::findPair(const char *begin, const char *end, char c1, char c2)
+{
+    return selected().findPair(begin, end, c1, c2);
+}
+
+const char* ByteSearch::findAnyOf(const char *begin, const char *end, const char *set, size_t setLen)
+{
+    if(setLen == 0)
+    {
+        return nullptr;
+    }
+    if(setLen > kMaxSetSize)
+    {
+        return findAnyOfScalar(begin, end, set, setLen);
+    }
+    return selected().findAnyOf(begin, end, set, setLen);
+}
+
+const char* ByteSearch::implementation()
+{
+    return selected().name;
+}
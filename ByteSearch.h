@@ -0,0 +1,26 @@
+#pragma once
+
+#include "noncopyable.h"
+
+#include <stddef.h>
+
+/*
+在[begin, end)中查找字节 返回第一个匹配的位置 找不到返回nullptr
+两字节序列和字节集合在x86上按CPU在第一次调用时选择AVX2或SSE2实现 其他平台使用标量实现
+单字节查找使用memchr
+*/
+class ByteSearch : noncopyable
+{
+public:
+    //findAnyOf支持的最大集合大小 超过时退回查表的标量实现
+    static const size_t kMaxSetSize = 16;
+
+    static const char* findByte(const char *begin, const char *end, char c);
+    //查找连续的两个字节c1 c2 返回c1的位置
+    static const char* findPair(const char *begin, const char *end, char c1, char c2);
+    //查找set[0, setLen)中任意一个字节
+    static const char* findAnyOf(const char *begin, const char *end, const char *set, size_t setLen);
+
+    //当前使用的实现 "avx2" "sse2" "scalar"
+    static const char* implementation();
+};
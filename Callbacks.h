@@ -18,6 +18,8 @@ using MessageCallback = std::function<void (const TcpConnectionPtr&,
 
 using HighWaterMarkCallback = std::function<void (const TcpConnectionPtr&, size_t)>;
 
+using TimerCallback = std::function<void()>;
+
 class Callbacks
 {
 private:
@@ -0,0 +1,150 @@
+#include "ChainBuffer.h"
+#include "BufferPool.h"
+
+#include <sys/uio.h>
+#include <limits.h>
+#include <errno.h>
+#include <string.h>
+
+const size_t ChainBuffer::kChunkSize;
+const size_t ChainBuffer::kMaxSpareChunks;
+const size_t ChainBuffer::kChunkDataSize;
+
+namespace
+{
+
+void deleteChunk(void *chunk)
+{
+    BufferPool::deallocate(static_cast<char*>(chunk), ChainBuffer::kChunkSize);
+}
+
+} // namespace
+
+ChainBuffer::ChainBuffer()
+    :   readable_(0)
+{
+}
+
+ChainBuffer::~ChainBuffer()
+{
+    for(Chunk *chunk : chunks_)
+    {
+        deleteChunk(chunk);
+    }
+    freeSpareChunks();
+}
+
+void ChainBuffer::append(const char *data, size_t len)
+{
+    readable_ += len;
+    while(len > 0)
+    {
+        if(chunks_.empty() || chunks_.back()->writeIndex == kChunkDataSize)
+        {
+            chunks_.push_back(newChunk());
+        }
+        Chunk *chunk = chunks_.back();
+        size_t n = len < kChunkDataSize - chunk->writeIndex ? len : kChunkDataSize - chunk->writeIndex;
+        memcpy(chunk->data + chunk->writeIndex, data, n);
+        chunk->writeIndex += n;
+        data += n;
+        len -= n;
+    }
+}
+
+void ChainBuffer::retrive(size_t len)
+{
+    if(len >= readable_)
+    {
+        retriveAll();
+        return;
+    }
+    readable_ -= len;
+    while(len > 0)
+    {
+        Chunk *chunk = chunks_.front();
+        size_t n = chunk->writeIndex - chunk->readIndex;
+        if(len < n)
+        {
+            chunk->readIndex += len;
+            break;
+        }
+        len -= n;
+        chunks_.pop_front();
+        releaseChunk(chunk);
+    }
+}
+
+void ChainBuffer::retriveAll()
+{
+    while(!chunks_.empty())
+    {
+        releaseChunk(chunks_.front());
+        chunks_.pop_front();
+    }
+    readable_ = 0;
+    //读空了 不再为这个连接留备用chunk
+    freeSpareChunks();
+}
+
+ssize_t ChainBuffer::writeFd(int fd, int *saveErrno)
+{
+    struct iovec vec[IOV_MAX];
+    int iovcnt = 0;
+    for(auto it = chunks_.begin(); it != chunks_.end() && iovcnt < IOV_MAX; ++it)
+    {
+        vec[iovcnt].iov_base = (*it)->data + (*it)->readIndex;
+        vec[iovcnt].iov_len = (*it)->writeIndex - (*it)->readIndex;
+        ++iovcnt;
+    }
+
+    const ssize_t n = ::writev(fd, vec, iovcnt);
+    if(n < 0)
+    {
+        *saveErrno = errno;
+    }
+    else
+    {
+        retrive(static_cast<size_t>(n));
+    }
+    return n;
+}
+
+ChainBuffer::Chunk* ChainBuffer::newChunk()
+{
+    Chunk *chunk;
+    if(!spare_.empty())
+    {
+        chunk = spare_.back();
+        spare_.pop_back();
+    }
+    else
+    {
+        size_t actualSize;
+        chunk = reinterpret_cast<Chunk*>(BufferPool::allocate(kChunkSize, &actualSize));
+    }
+    chunk->readIndex = 0;
+    chunk->writeIndex = 0;
+    return chunk;
+}
+
+void ChainBuffer::releaseChunk(Chunk *chunk)
+{
+    if(spare_.size() < kMaxSpareChunks)
+    {
+        spare_.push_back(chunk);
+    }
+    else
+    {
+        deleteChunk(chunk);
+    }
+}
+
+void ChainBuffer::freeSpareChunks()
+{
+    for(Chunk *chunk : spare_)
+    {
+        deleteChunk(chunk);
+    }
+    spare_.clear();
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "noncopyable.h"
+
+#include <deque>
+#include <vector>
+#include <sys/types.h>
+#include <stddef.h>
+
+/*
+分段的发送缓冲区  由固定大小的chunk组成 用deque串起来
+    append只会在最后一个chunk后面追加或者挂上新的chunk 已有的数据永远不会被移动或者重新拷贝
+    writeFd用一次writev把最多IOV_MAX个chunk写到fd
+    chunk从BufferPool中分配 与Buffer共用同一个大小等级
+    读完的chunk最多留一个备用 缓冲区读空时全部还给BufferPool 空闲连接不占用chunk
+适合TcpConnection的outputBuffer_: 大量数据流式发送时不会反复扩容拷贝
+*/
+class ChainBuffer : noncopyable
+{
+public:
+    static const size_t kChunkSize = 16 * 1024;     //包括chunk头部 正好是BufferPool的一个等级
+    static const size_t kMaxSpareChunks = 1;
+
+    ChainBuffer();
+    ~ChainBuffer();
+
+    size_t readableBytes() const { return readable_; }
+    size_t numChunks() const { return chunks_.size(); }
+
+    //把 [data , data + len] 拷贝到缓冲区末尾
+    void append(const char *data, size_t len);
+
+    //丢弃前len个字节
+    void retrive(size_t len);
+    void retriveAll();
+
+    //向fd写数据 写成功的部分从缓冲区中取走  返回值同writev
+    ssize_t writeFd(int fd, int *saveErrno);
+
+private:
+    struct Chunk
+    {
+        size_t readIndex;
+        size_t writeIndex;
+        char data[kChunkSize - 2 * sizeof(size_t)];
+    };
+    static const size_t kChunkDataSize = sizeof(Chunk::data);
+
+    Chunk* newChunk();
+    void releaseChunk(Chunk *chunk);
+    void freeSpareChunks();
+
+    std::deque<Chunk*> chunks_;
+    std::vector<Chunk*> spare_;
+    size_t readable_;
+};
@@ -6,6 +6,8 @@
 const int Channel::kNoneEvent = 0;
 const int Channel::kReadEvent = EPOLLIN | EPOLLPRI;
 const int Channel::kWriteEvent = EPOLLOUT;
+const int Channel::kEdgeTriggered = EPOLLET;
+const int Channel::kCompletionEvent = EPOLLMSG;
 
 Channel::Channel(EventLoop *loop, int fd)
       : loop_(loop),
@@ -13,6 +15,7 @@ Channel::Channel(EventLoop *loop, int fd)
         events_(0),
         revents_(0),
         index_(-1),
+        edgeTriggered_(false),
         tied_(false)
 {
 }
@@ -77,7 +80,7 @@ void Channel::handleEventWithGuard(Timestamp receiveTime)
 
     */
     //EPOLLHUP 表示读写都关闭
-    LOG_INFO("channel handleEvent revents : %d\n", revents_);
+    LOG_DEBUG("channel handleEvent revents : %d\n", revents_);
     if( (revents_ & EPOLLHUP) && !(revents_ & EPOLLIN))
     {
         if(closeCallback_)
@@ -111,6 +114,14 @@ void Channel::handleEventWithGuard(Timestamp receiveTime)
         }
     }
 
+    if( (revents_ & kCompletionEvent) )
+    {
+        if(completionCallback_)
+        {
+            completionCallback_(receiveTime);
+        }
+    }
+
 
 }
 
@@ -41,12 +41,15 @@ public:
     void setWriteCallback(EventCallback cb)  { writeCallback_ = std::move(cb); }
     void setCloseCallback(EventCallback cb)  { closeCallback_ = std::move(cb); }
     void setErrorCallback(EventCallback cb)  { errorCallback_ = std::move(cb); }
+    //io_uring完成模式下 收发结果由poller以kCompletionEvent上报
+    void setCompletionCallback(ReadEventCallback cb)  { completionCallback_ = std::move(cb); }
 
     //防止当channel被手动remove后， channel还在执行回调操作
     void tie(const std::shared_ptr<void>&);
 
     int fd() const { return fd_; }
-    int events() const { return events_; }
+    //边缘触发时带上EPOLLET 交给poller注册
+    int events() const { return edgeTriggered_ ? events_ | kEdgeTriggered : events_; }
     int revents() const { return revents_; }
     void set_revents(int revt) { revents_ = revt; }
 
@@ -62,6 +65,13 @@ public:
     bool isReading() const { return events_ & kReadEvent; }
     bool isWriting() const { return events_ & kWriteEvent; }
 
+    //默认水平触发 打开后由回调负责把数据读写到EAGAIN 需要在注册到poller之前设置
+    void setEdgeTriggered(bool on) { edgeTriggered_ = on; }
+    bool edgeTriggered() const { return edgeTriggered_; }
+
+    //不是epoll事件 IoUringPoller用来通知fd上有完成的收发
+    static const int kCompletionEvent;
+
     int index() { return index_; }
     void set_index(int idx) { index_ = idx; }
 
@@ -80,12 +90,14 @@ private:
     static const int kNoneEvent;
     static const int kReadEvent;
     static const int kWriteEvent;
+    static const int kEdgeTriggered;
 
     EventLoop *loop_; //事件循环
     const int fd_;    //fd,poller监听的对象
     int events_;      //注册fd感兴趣的事件
     int revents_;     //poller返回的具体发生的事件
     int index_;
+    bool edgeTriggered_;
 
     std::weak_ptr<void> tie_;
     bool tied_;
@@ -96,6 +108,7 @@ private:
     EventCallback writeCallback_;
     EventCallback closeCallback_;
     EventCallback errorCallback_;
+    ReadEventCallback completionCallback_;
 
 
 };
@@ -1,16 +1,27 @@
 #include "Poller.h"
 #include "EpollPoller.h"
+#include "IoUringPoller.h"
+#include "PollPoller.h"
+#include "Logger.h"
 #include <stdlib.h>
 
 Poller* Poller::newDefaultPoller(EventLoop *loop)
 {
-    if(::getenv("MUDUO_USE_POLL"))
+    if(::getenv("MUDUO_USE_URING"))
     {
-        return nullptr;//生成poll实例
+        IoUringPoller *poller = new IoUringPoller(loop);
+        if(poller->valid())
+        {
+            return poller;//生成io_uring实例
+        }
+        //内核不支持或禁用了io_uring 退回epoll
+        delete poller;
+        LOG_ERROR("io_uring is not available, fall back to epoll \n");
     }
-    else
+    else if(::getenv("MUDUO_USE_POLL"))
     {
-        return new EpollPoller(loop);//默认生成epoll实例
+        return new PollPoller(loop);//生成poll实例
     }
+    return new EpollPoller(loop);//默认生成epoll实例
 
-}
\ No newline at end of file
+}
@@ -5,6 +5,7 @@
 #include <errno.h>
 #include <unistd.h>
 #include <string.h>
+#include <algorithm>
 
 //对应channel中的成员变量  index_ = -1
 //channel不在ChannelMap中 
@@ -14,6 +15,9 @@ const int kAdded = 1;
 //channel从poller删除但仍在ChannelMap中 
 const int kDeleted = 2;
 
+//kernelEvents_中表示fd没有注册到epoll
+const int kNotRegistered = -1;
+
 EpollPoller::EpollPoller(EventLoop *loop)
     : Poller(loop),
       epollfd_(::epoll_create1(EPOLL_CLOEXEC)),
@@ -36,9 +40,10 @@ EpollPoller::~EpollPoller()
 //                      int maxevents, int timeout);
 Timestamp EpollPoller::poll(int timeoutMs, ChannelList *activeChannels) 
 {
-    //用LOG_DEBUG更合理
-    LOG_INFO("func = %s => fd total count= %lu \n",
-            __FUNCTION__, channels_.size());
+    //poll和事件分发在热路径上 只输出DEBUG日志
+    LOG_DEBUG("func = %s => fd total count= %lu \n",
+            __FUNCTION__, numChannels());
+    flushUpdates();
     //events_用于回传待处理事件的数组
     //events_.begin()先解引用 * 得到首元素，再对首元素取地址 &
     int numEvents = ::epoll_wait(epollfd_, &*events_.begin(), 
@@ -49,7 +54,7 @@ Timestamp EpollPoller::poll(int timeoutMs, ChannelList *activeChannels)
 
     if(numEvents > 0)
     {
-        LOG_INFO(" %d events happend \n", numEvents);
+        LOG_DEBUG(" %d events happend \n", numEvents);
 
         fillActiveChannels(numEvents, activeChannels);
 
@@ -84,59 +89,105 @@ Timestamp EpollPoller::poll(int timeoutMs, ChannelList *activeChannels)
     ChannelList             Poller
                             ChannelMap <fd, Channel*>  epollfd
 */
+//这里只改channel的状态并记下fd 真正的epoll_ctl推迟到下一次poll之前
+//同一轮里先disableWriting再enableWriting这种来回切换就不用进内核了
 void EpollPoller::updateChannel(Channel *channel) 
 {
     const int index = channel->index();
-    LOG_INFO("func = %s => fd = %d events = %d index = %d \n",
+    LOG_DEBUG("func = %s => fd = %d events = %d index = %d \n",
             __FUNCTION__, channel->fd(), channel->events(), channel->index());
             
     if(index == kNew || index == kDeleted)
     {
         if(index == kNew) //channel不在ChannelMap中 
         {
-            int fd = channel->fd();
-            channels_[fd] = channel;
+            addChannel(channel);
         }
         channel->set_index(kAdded); 
-        update(EPOLL_CTL_ADD, channel);
     }
-    else //channel已经在poller上注册过了
+    else if(channel->isNoneEvent()) //channel已经在poller上注册过了
     {
-        int fd = channel->fd();
-        if(channel->isNoneEvent())
-        {
-            update(EPOLL_CTL_DEL, channel);
-            channel->set_index(kDeleted);
-        }
-        else
-        {
-            update(EPOLL_CTL_MOD, channel);
-        }
-
+        channel->set_index(kDeleted);
     }
+    markDirty(channel->fd());
 
 }
 
 
 //1.epoll_ctl delete 2. 从ChannelMap中移除 
+//删除马上生效 不能推迟: 移除后fd随时可能被close 再被新连接复用
 void EpollPoller::removeChannel(Channel *channel)
 {
-    int fd = channel->fd();
-    channels_.erase(fd);
+    eraseChannel(channel);
 
-    LOG_INFO("func = %s => fd = %d events = %d index = %d \n",
+    LOG_DEBUG("func = %s => fd = %d events = %d index = %d \n",
             __FUNCTION__, channel->fd(), channel->events(), channel->index());
     
-    int index = channel->index();
-    if(index == kAdded)
+    const size_t fd = static_cast<size_t>(channel->fd());
+    if(fd < kernelEvents_.size())
     {
-        update(EPOLL_CTL_DEL, channel);
+        if(kernelEvents_[fd] != kNotRegistered)
+        {
+            update(EPOLL_CTL_DEL, channel);
+            kernelEvents_[fd] = kNotRegistered;
+        }
+        dirty_[fd] = 0;     //还没提交的变化作废
     }
     channel->set_index(kNew);
 
 
 }
 
+void EpollPoller::markDirty(int fd)
+{
+    const size_t index = static_cast<size_t>(fd);
+    if(index >= kernelEvents_.size())
+    {
+        const size_t size = std::max(index + 1, kernelEvents_.size() * 2);
+        kernelEvents_.resize(size, kNotRegistered);
+        dirty_.resize(size, 0);
+    }
+    if(!dirty_[index])
+    {
+        dirty_[index] = 1;
+        dirtyFds_.push_back(fd);
+    }
+}
+
+void EpollPoller::flushUpdates()
+{
+    for(int fd : dirtyFds_)
+    {
+        //中途被removeChannel的fd标记已经清掉了
+        if(!dirty_[fd])
+        {
+            continue;
+        }
+        dirty_[fd] = 0;
+
+        Channel *channel = channels_[fd];
+        int &registered = kernelEvents_[fd];
+        if(channel->index() == kAdded)
+        {
+            if(registered == kNotRegistered)
+            {
+                update(EPOLL_CTL_ADD, channel);
+            }
+            else if(registered != channel->events())
+            {
+                update(EPOLL_CTL_MOD, channel);
+            }
+            registered = channel->events();
+        }
+        else if(registered != kNotRegistered)   //kDeleted
+        {
+            update(EPOLL_CTL_DEL, channel);
+            registered = kNotRegistered;
+        }
+    }
+    dirtyFds_.clear();
+}
+
 //填写活跃的连接
 void EpollPoller::fillActiveChannels(int numEvents, ChannelList* activeChannels) const
 {
@@ -144,14 +195,8 @@ void EpollPoller::fillActiveChannels(int numEvents, ChannelList* activeChannels)
     {
         //LOG_INFO(" fillActiveChannels i = %d \n", i);
         //此时已经将所有就绪的事件从内核事件表中复制到events_指向的数组中
-        auto it = channels_.find(events_[i].data.fd);
-        Channel* channel = it->second;
-        //Channel* channel = static_cast<Channel*>(events_[i].data.ptr);
-
-        //std::cout << typeid(channel).name() << std::endl;
-        //std::cout << channel << " " << events_[i].data.ptr;
-        /*LOG_INFO(" fillActiveChannels events_[i].events: %d channel->revents_: %d\n"
-        ,events_[i].events, channel->revents());*/
+        //注册时data.ptr存的就是channel 不用再按fd查表
+        Channel* channel = static_cast<Channel*>(events_[i].data.ptr);
         channel->set_revents(events_[i].events);
         //EventLoop拿到了Poller返回给它的所有发生事件的channel列表
         activeChannels->push_back(channel);
@@ -166,8 +211,8 @@ void EpollPoller::update(int operation, Channel *channel)
     bzero(&event, sizeof event);
     int fd = channel->fd();
     event.events = channel->events();
+    //data是union ptr和fd只能存一个 存channel指针 fd可以从channel里取
     event.data.ptr = channel;
-    event.data.fd = fd;
     
     /*
     通过epoll_ctl函数添加进来的事件event都会被放在红黑树的某个节点内
@@ -36,9 +36,19 @@ private:
     void fillActiveChannels(int numEvents, ChannelList *activeChannels) const;
     //更新channel通道
     void update(int operation, Channel *channel);
+    //记录fd的关注事件有变化 下一次epoll_wait之前统一提交
+    void markDirty(int fd);
+    //把一轮循环中累积的变化合并后提交给内核 前后相同的变化直接丢掉
+    void flushUpdates();
 
     using EventList = std::vector<epoll_event>;
 
     int epollfd_;
     EventList events_;
+
+    //下标是fd 已经通过epoll_ctl提交给内核的事件  kNotRegistered表示不在epoll中
+    std::vector<int> kernelEvents_;
+    //本轮有变化的fd  dirty_[fd]标记是否已经在dirtyFds_中
+    std::vector<int> dirtyFds_;
+    std::vector<char> dirty_;
 };
@@ -1,7 +1,10 @@
 #include "EventLoop.h"
 #include "Logger.h"
 #include "Poller.h"
+#include "IoUringPoller.h"
 #include "Channel.h"
+#include "TimerQueue.h"
+#include "TimingWheel.h"
 
 #include <sys/eventfd.h>
 #include <unistd.h>
@@ -42,11 +45,15 @@ int createEventfd()
 EventLoop::EventLoop()
         : looping_(false),
           quit_(false),
-          callingPendingFunctors_(false),
           threadId_(CurrentThread::tid()),
+          pollReturnMonotonic_(Timestamp::monotonicMicroseconds()),
           poller_(Poller::newDefaultPoller(this)),
+          completionIo_(nullptr),
           wakeupFd_(createEventfd()),
-          wakeupChannel_(new Channel(this,wakeupFd_))
+          wakeupChannel_(new Channel(this,wakeupFd_)),
+          timerQueue_(new TimerQueue(this)),
+          callingPendingFunctors_(false),
+          wakeupPending_(false)
 {
     LOG_DEBUG("EventLoop created %p in thread %d\n", this, threadId_);
     if(t_loopInThisThread)
@@ -59,6 +66,12 @@ EventLoop::EventLoop()
         t_loopInThisThread = this;
     }
 
+    IoUringPoller *uring = dynamic_cast<IoUringPoller*>(poller_.get());
+    if(uring != nullptr && uring->completionIoEnabled())
+    {
+        completionIo_ = uring;
+    }
+
     //设置wakeupfd的事件类型和对应的回调操作
     wakeupChannel_->setReadCallback(std::bind(&EventLoop::handleRead, this));
     //eventloop将监听wakeupchannel的EPOLLIN读事件   
@@ -88,6 +101,8 @@ void EventLoop::loop()
         activeChannels_.clear();
         //监听两类fd  一种是clientfd 一种是wakeupfd mainloop <=>subloop
         pollReturnTime_ = poller_->poll(kPollTimeMs, &activeChannels_);
+        //每轮循环只读一次时钟 回调中通过pollReturnTime() / pollReturnMonotonic()获取当前时间
+        pollReturnMonotonic_ = Timestamp::monotonicMicroseconds();
         for(Channel *channel : activeChannels_)
         {
             //poller监听哪些channel发生了事件 然后上报给EventLoop 通知Channel处理相应的事件
@@ -126,23 +141,24 @@ void EventLoop::runInLoop(Functor cb)
     }
     else        //在非当前loop线程中执行cb，就需要唤醒loop所在的线程执行cb
     {
-        queueInLoop(cb);
+        queueInLoop(std::move(cb));
     }
 
 }
 //把cb放入队列中，唤醒loop所在的线程执行cb
 void EventLoop::queueInLoop(Functor cb)
 {
-    {
-        std::unique_lock<std::mutex> lock(mutex_);
-        pendingFunctors_.emplace_back(cb);
-    }
+    pendingFunctors_.push(std::move(cb));
 
     //唤醒相应的线程
     //  || callingPendingFunctors_ 的意思是 ： 当前loop正在执行回调 但是loop又有了新的回调
+    //从loop读走eventfd到下一次读走之间 只有第一个回调需要写eventfd 其余的会在同一轮被执行
     if(!isInLoopThread() || callingPendingFunctors_)
     {
-        wakeup();
+        if(!wakeupPending_.exchange(true, std::memory_order_acq_rel))
+        {
+            wakeup();
+        }
     }
 
 }
@@ -158,6 +174,41 @@ void EventLoop::wakeup()
     }
 }
 
+//定时器内部使用单调时钟 墙上时间只在runAt中换算一次
+TimerId EventLoop::runAt(Timestamp time, TimerCallback cb)
+{
+    int64_t delay = time.microSecondsSinceEpoch() - Timestamp::now().microSecondsSinceEpoch();
+    return timerQueue_->addTimer(std::move(cb), Timestamp::monotonicMicroseconds() + delay, 0.0);
+}
+
+TimerId EventLoop::runAfter(double delay, TimerCallback cb)
+{
+    int64_t expiration = Timestamp::monotonicMicroseconds()
+                        + static_cast<int64_t>(delay * Timestamp::kMicroSecondsPerSecond);
+    return timerQueue_->addTimer(std::move(cb), expiration, 0.0);
+}
+
+TimerId EventLoop::runEvery(double interval, TimerCallback cb)
+{
+    int64_t expiration = Timestamp::monotonicMicroseconds()
+                        + static_cast<int64_t>(interval * Timestamp::kMicroSecondsPerSecond);
+    return timerQueue_->addTimer(std::move(cb), expiration, interval);
+}
+
+void EventLoop::cancel(TimerId timerId)
+{
+    timerQueue_->cancel(timerId);
+}
+
+TimingWheel* EventLoop::timingWheel()
+{
+    if(!timingWheel_)
+    {
+        timingWheel_.reset(new TimingWheel(this));
+    }
+    return timingWheel_.get();
+}
+
 //Eventloop 的方法 => 调用 Poller的方法
 void EventLoop::updateChannel(Channel *channel)
 {
@@ -191,23 +242,18 @@ void EventLoop::handleRead()
     {
         LOG_ERROR("EventLoop::handleRead() reads %lu bytes instead of 8",n);
     }
+    //之后的queueInLoop重新写eventfd 在这之前加入的回调都会在本轮doPendingFunctors中执行
+    //用exchange而不是store: 和生产者的exchange同步 保证看得到它们push的节点
+    wakeupPending_.exchange(false, std::memory_order_acq_rel);
 }
 
 //执行回调
 void EventLoop::doPendingFunctors()
 {
-    std::vector<Functor> functors;//定义一个局部的functors
     callingPendingFunctors_ = true;
 
-    {
-        std::unique_lock<std::mutex> lock(mutex_);
-        //和pendingFunctors_交换内容 尽快释放pendingFunctors_
-        functors.swap(pendingFunctors_);
-    }
-    for(const Functor &functor : functors)
-    {
-        functor();//执行当前loop需要执行的回调
-    }
+    //按加入的顺序执行本轮开始前已经在队列中的回调 不需要加锁
+    pendingFunctors_.runPending();
     
     callingPendingFunctors_ = false;
 
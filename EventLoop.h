@@ -3,21 +3,27 @@
 #include <vector>
 #include <atomic>
 #include <memory>
-#include <mutex>
 
 #include "noncopyable.h"
 #include "Timestamp.h"
 #include "CurrentThread.h"
+#include "Callbacks.h"
+#include "TimerId.h"
+#include "FunctorQueue.h"
 
 class Channel;
 class Poller;
+class IoUringPoller;
+class TimerQueue;
+class TimingWheel;
 
 //事件循环类  主要包含了两个大模块
 //1. Channel   2. Poller (epoll的抽象)
 class EventLoop : noncopyable
 {
 public:
-    using Functor = std::function<void()>;
+    //只能移动 小于64字节的回调(绑定了shared_ptr的std::bind 捕获几个值的lambda)不分配内存
+    using Functor = InlineFunctor;
     EventLoop();
     ~EventLoop();
     
@@ -26,7 +32,11 @@ public:
     //退出事件循环
     void quit();
 
+    //本轮poll返回的时间 每轮循环缓存一次 回调中读取不需要系统调用
+    //墙上时间 用于显示
     Timestamp pollReturnTime() const { return pollReturnTime_; }
+    //单调时钟(微秒) 用于计算耗时
+    int64_t pollReturnMonotonic() const { return pollReturnMonotonic_; }
 
     //在当前loop中执行cb
     void runInLoop(Functor cb);
@@ -36,11 +46,27 @@ public:
     //唤醒loop所在的线程
     void wakeup();
 
+    //定时器 线程安全 可以在其他线程中调用
+    //在time时刻执行cb
+    TimerId runAt(Timestamp time, TimerCallback cb);
+    //delay秒之后执行cb
+    TimerId runAfter(double delay, TimerCallback cb);
+    //每隔interval秒执行一次cb
+    TimerId runEvery(double interval, TimerCallback cb);
+    //取消定时器
+    void cancel(TimerId timerId);
+
+    //空闲连接超时使用的时间轮 第一次调用时创建 只能在loop线程中调用
+    TimingWheel* timingWheel();
+
     //Eventloop 的方法 => 调用 Poller的方法
     void updateChannel(Channel *channel);
     void removeChannel(Channel *channel);
     bool hasChannel(Channel *channel);
 
+    //poller是支持完成模式的IoUringPoller时返回它 否则为nullptr
+    IoUringPoller* completionIo() const { return completionIo_; }
+
     //判断EventLoop对象是否在自己的线程里面
     bool isInLoopThread() const { return threadId_ == CurrentThread::tid();}
 
@@ -57,20 +83,28 @@ private:
     const pid_t threadId_;  //记录创建了当前loop所在线程的tid
 
     Timestamp pollReturnTime_;  //poller返回发生事件的channels的时间点
+    int64_t pollReturnMonotonic_;
     std::unique_ptr<Poller> poller_;
+    IoUringPoller *completionIo_;
 
     //当mainloop获取到一个新用户的channel,通过轮询算法选择一个subloop,
     //通过wakeupFd_唤醒subloop处理channel上的事件
     int wakeupFd_;
     std::unique_ptr<Channel> wakeupChannel_;
 
+    //定时器队列 基于timerfd 和其他channel一起由poller监听
+    std::unique_ptr<TimerQueue> timerQueue_;
+    //依赖timerQueue_ 必须在其后声明 先于timerQueue_析构
+    std::unique_ptr<TimingWheel> timingWheel_;
+
     ChannelList activeChannels_;
 
     //标识当前的loop是否有在执行回调操作
     std::atomic_bool callingPendingFunctors_;  
-    //存储loop需要执行的回调操作
-    std::vector<Functor> pendingFunctors_;
-    std::mutex mutex_;  //互斥锁 保护上面的vector容器的线程安全操作
+    //存储loop需要执行的回调操作 无锁的多生产者单消费者队列
+    FunctorQueue pendingFunctors_;
+    //已经写过wakeupFd_ loop还没有读走 这期间queueInLoop不需要再写
+    std::atomic_bool wakeupPending_;
 
 
 
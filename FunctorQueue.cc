@@ -0,0 +1,235 @@
+#include "FunctorQueue.h"
+
+/*
+每个线程一个节点缓存 (所有FunctorQueue共用)
+    分配: 先用本线程的空闲链表 空了再一次性取走returned上别的线程还回来的节点 都没有才new
+    回收: loop线程执行完回调后把节点压回所属缓存的returned栈(无锁)
+    只有所属线程会整体exchange走returned 没有ABA问题
+线程退出时缓存标记为dead 之后还回来的节点直接delete
+refs = 1(所属线程) + 缓存创建的节点数 减到0的一方释放缓存
+*/
+struct FunctorQueue::NodeCache
+{
+    std::atomic<Node*> returned;
+    Node *local;
+    std::atomic<int> refs;
+    std::atomic<bool> dead;
+
+    NodeCache()
+        :   returned(nullptr), local(nullptr), refs(1), dead(false)
+    {}
+};
+
+namespace
+{
+
+using Node = FunctorQueue::Node;
+using NodeCache = FunctorQueue::NodeCache;
+
+void releaseCache(NodeCache *cache)
+{
+    if(cache->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    {
+        delete cache;
+    }
+}
+
+void deleteList(Node *node)
+{
+    while(node != nullptr)
+    {
+        Node *next = node->next.load(std::memory_order_relaxed);
+        NodeCache *cache = node->owner;
+        delete node;
+        releaseCache(cache);
+        node = next;
+    }
+}
+
+__thread bool t_nodeCacheDestroyed = false;
+
+class ThreadNodeCache
+{
+public:
+    ThreadNodeCache()
+        :   cache_(new NodeCache)
+    {}
+
+    ~ThreadNodeCache()
+    {
+        t_nodeCacheDestroyed = true;
+        cache_->dead.store(true, std::memory_order_seq_cst);
+        deleteList(cache_->local);
+        cache_->local = nullptr;
+        deleteList(cache_->returned.exchange(nullptr, std::memory_order_seq_cst));
+        releaseCache(cache_);
+    }
+
+    Node* allocate()
+    {
+        Node *node = cache_->local;
+        if(node == nullptr)
+        {
+            node = cache_->returned.exchange(nullptr, std::memory_order_acquire);
+            if(node == nullptr)
+            {
+                cache_->refs.fetch_add(1, std::memory_order_relaxed);
+                node = new Node;
+                node->owner = cache_;
+                return node;
+            }
+        }
+        cache_->local = node->next.load(std::memory_order_relaxed);
+        return node;
+    }
+
+private:
+    NodeCache *cache_;
+};
+
+thread_local ThreadNodeCache t_nodeCache;
+
+//线程退出过程中(本线程的缓存已经析构)push的节点 归属于这个不会释放的缓存 执行完直接delete
+NodeCache* orphanCache()
+{
+    static NodeCache *cache = []
+    {
+        NodeCache *c = new NodeCache;
+        c->dead.store(true);
+        return c;
+    }();
+    return cache;
+}
+
+Node* allocateNode()
+{
+    if(t_nodeCacheDestroyed)
+    {
+        NodeCache *cache = orphanCache();
+        cache->refs.fetch_add(1, std::memory_order_relaxed);
+        Node *node = new Node;
+        node->owner = cache;
+        return node;
+    }
+    return t_nodeCache.allocate();
+}
+
+//节点执行完之后调用 可能在任意线程
+void freeNode(Node *node)
+{
+    NodeCache *cache = node->owner;
+    if(cache->dead.load(std::memory_order_acquire))
+    {
+        delete node;
+        releaseCache(cache);
+        return;
+    }
+    //压栈之后节点可能马上被退出的线程delete 并释放它持有的引用 这里另外持有一个引用
+    cache->refs.fetch_add(1, std::memory_order_relaxed);
+    Node *head = cache->returned.load(std::memory_order_relaxed);
+    do
+    {
+        node->next.store(head, std::memory_order_relaxed);
+    } while(!cache->returned.compare_exchange_weak(head, node,
+                std::memory_order_seq_cst, std::memory_order_relaxed));
+    //压栈的同时所属线程退出了 它可能已经清理过returned 由这里清理
+    if(cache->dead.load(std::memory_order_seq_cst))
+    {
+        deleteList(cache->returned.exchange(nullptr, std::memory_order_seq_cst));
+    }
+    releaseCache(cache);
+}
+
+} // namespace
+
+FunctorQueue::FunctorQueue()
+    :   head_(&stub_),
+        tail_(&stub_)
+{
+    stub_.next.store(nullptr, std::memory_order_relaxed);
+    stub_.owner = nullptr;
+}
+
+FunctorQueue::~FunctorQueue()
+{
+    while(Node *node = pop())
+    {
+        node->functor.reset();
+        freeNode(node);
+    }
+}
+
+void FunctorQueue::push(Functor cb)
+{
+    Node *node = allocateNode();
+    node->functor = std::move(cb);
+    pushNode(node);
+}
+
+void FunctorQueue::pushNode(Node *node)
+{
+    node->next.store(nullptr, std::memory_order_relaxed);
+    //exchange之后 到prev->next被设置之前 链表是断开的 消费者会在这里停下等下一轮
+    Node *prev = head_.exchange(node, std::memory_order_acq_rel);
+    prev->next.store(node, std::memory_order_release);
+}
+
+FunctorQueue::Node* FunctorQueue::pop()
+{
+    Node *tail = tail_;
+    Node *next = tail->next.load(std::memory_order_acquire);
+    if(tail == &stub_)
+    {
+        if(next == nullptr)
+        {
+            return nullptr;
+        }
+        tail_ = next;
+        tail = next;
+        next = next->next.load(std::memory_order_acquire);
+    }
+    if(next != nullptr)
+    {
+        tail_ = next;
+        return tail;
+    }
+    //tail是最后一个节点 把stub放回队尾才能取出它
+    if(tail != head_.load(std::memory_order_acquire))
+    {
+        return nullptr;
+    }
+    pushNode(&stub_);
+    next = tail->next.load(std::memory_order_acquire);
+    if(next != nullptr)
+    {
+        tail_ = next;
+        return tail;
+    }
+    return nullptr;
+}
+
+size_t FunctorQueue::runPending()
+{
+    //只执行到开始时的最后一个节点 回调中再queueInLoop的留到下一轮 和原来交换vector的语义一致
+    //last是stub时(pop把stub放回了队尾) 要执行的是stub前面的节点 取到stub为止
+    Node *last = head_.load(std::memory_order_acquire);
+    size_t n = 0;
+    while(!(last == &stub_ && tail_ == &stub_))
+    {
+        Node *node = pop();
+        if(node == nullptr)
+        {
+            break;  //生产者还没有链接好 它push之后会wakeup 下一轮再取
+        }
+        bool done = node == last;
+        node->functor();
+        node->functor.reset();  //回调持有的资源(比如TcpConnectionPtr)在这里释放 不留在缓存中
+        freeNode(node);
+        ++n;
+        if(done)
+        {
+            break;
+        }
+    }
+    return n;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "noncopyable.h"
+#include "InlineFunctor.h"
+
+#include <atomic>
+#include <stddef.h>
+
+/*
+EventLoop待执行回调的队列  多生产者单消费者 无锁(Vyukov的侵入式MPSC队列)
+    push: 任意线程 一次exchange + 一次store 不会阻塞其他生产者
+    runPending: 只在loop线程中调用 按push的顺序执行回调
+链表的尾部有一个stub节点 队列空时head_和tail_都指向它
+节点由push所在线程的NodeCache分配 执行完之后还给这个NodeCache 稳定运行时不分配内存
+*/
+class FunctorQueue : noncopyable
+{
+public:
+    using Functor = InlineFunctor;
+
+    FunctorQueue();
+    ~FunctorQueue();
+
+    void push(Functor cb);
+
+    //执行调用开始时已经在队列中的回调 执行期间新加入的留到下一次 返回执行的个数
+    size_t runPending();
+
+    struct NodeCache;
+
+    struct Node
+    {
+        std::atomic<Node*> next;    //队列中的下一个节点 回收后是空闲链表中的下一个节点
+        NodeCache *owner;           //分配这个节点的线程缓存
+        Functor functor;
+    };
+
+private:
+    void pushNode(Node *node);
+    //取出最早的节点 队列为空或者有生产者正在链接节点时返回nullptr
+    Node* pop();
+
+    std::atomic<Node*> head_;  //最后push的节点 生产者之间竞争
+    char pad_[64];              //head_和tail_放在不同的cache line
+    Node *tail_;                //下一个要取出的节点 只有消费者访问
+    Node stub_;
+};
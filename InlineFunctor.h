@@ -0,0 +1,156 @@
+#pragma once
+
+#include <stddef.h>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+/*
+只能移动的void()可调用对象  和std::function的区别是有kInlineSize字节的内联存储
+    std::bind(&X::f, shared_ptr, ...)和捕获几个指针/shared_ptr的lambda都能放进内联存储 不分配内存
+    放不下(或者移动构造可能抛异常)的对象才在堆上分配
+只能移动 不能拷贝 整个对象64字节
+*/
+class InlineFunctor
+{
+public:
+    static const size_t kInlineSize = 64 - sizeof(void*);
+
+    InlineFunctor()
+        :   ops_(nullptr)
+    {}
+    InlineFunctor(std::nullptr_t)
+        :   ops_(nullptr)
+    {}
+
+    template<typename F,
+            typename = typename std::enable_if<
+                !std::is_same<typename std::decay<F>::type, InlineFunctor>::value>::type>
+    InlineFunctor(F &&f)
+        :   ops_(nullptr)
+    {
+        using Func = typename std::decay<F>::type;
+        init<Func>(std::forward<F>(f), std::integral_constant<bool, fitsInline<Func>()>());
+    }
+
+    InlineFunctor(InlineFunctor &&rhs) noexcept
+        :   ops_(rhs.ops_)
+    {
+        if(ops_ != nullptr)
+        {
+            ops_->move(&storage_, &rhs.storage_);
+            rhs.ops_ = nullptr;
+        }
+    }
+
+    InlineFunctor& operator=(InlineFunctor &&rhs) noexcept
+    {
+        if(this != &rhs)
+        {
+            reset();
+            if(rhs.ops_ != nullptr)
+            {
+                rhs.ops_->move(&storage_, &rhs.storage_);
+                ops_ = rhs.ops_;
+                rhs.ops_ = nullptr;
+            }
+        }
+        return *this;
+    }
+
+    InlineFunctor(const InlineFunctor&) = delete;
+    InlineFunctor& operator=(const InlineFunctor&) = delete;
+
+    ~InlineFunctor()
+    {
+        reset();
+    }
+
+    void operator()()   { ops_->invoke(&storage_); }
+    explicit operator bool() const  { return ops_ != nullptr; }
+
+    void reset()
+    {
+        if(ops_ != nullptr)
+        {
+            ops_->destroy(&storage_);
+            ops_ = nullptr;
+        }
+    }
+
+private:
+    struct Ops
+    {
+        void (*invoke)(void *storage);
+        void (*move)(void *dst, void *src);   //移动到dst 并析构src
+        void (*destroy)(void *storage);
+    };
+
+    template<typename Func>
+    static constexpr bool fitsInline()
+    {
+        return sizeof(Func) <= kInlineSize
+            && alignof(Func) <= alignof(void*)
+            && std::is_nothrow_move_constructible<Func>::value;
+    }
+
+    //对象直接放在storage_中
+    template<typename Func>
+    struct LocalOps
+    {
+        static void invoke(void *s)   { (*static_cast<Func*>(s))(); }
+        static void move(void *dst, void *src)
+        {
+            new (dst) Func(std::move(*static_cast<Func*>(src)));
+            static_cast<Func*>(src)->~Func();
+        }
+        static void destroy(void *s)  { static_cast<Func*>(s)->~Func(); }
+        static const Ops kOps;
+    };
+
+    //storage_中只放指向堆上对象的指针
+    template<typename Func>
+    struct HeapOps
+    {
+        static void invoke(void *s)   { (**static_cast<Func**>(s))(); }
+        static void move(void *dst, void *src)
+        {
+            *static_cast<Func**>(dst) = *static_cast<Func**>(src);
+        }
+        static void destroy(void *s)  { delete *static_cast<Func**>(s); }
+        static const Ops kOps;
+    };
+
+    template<typename Func, typename F>
+    void init(F &&f, std::true_type)
+    {
+        new (&storage_) Func(std::forward<F>(f));
+        ops_ = &LocalOps<Func>::kOps;
+    }
+
+    template<typename Func, typename F>
+    void init(F &&f, std::false_type)
+    {
+        *reinterpret_cast<Func**>(&storage_) = new Func(std::forward<F>(f));
+        ops_ = &HeapOps<Func>::kOps;
+    }
+
+    typename std::aligned_storage<kInlineSize, alignof(void*)>::type storage_;
+    const Ops *ops_;
+};
+
+template<typename Func>
+const InlineFunctor::Ops InlineFunctor::LocalOps<Func>::kOps =
+{
+    &InlineFunctor::LocalOps<Func>::invoke,
+    &InlineFunctor::LocalOps<Func>::move,
+    &InlineFunctor::LocalOps<Func>::destroy,
+};
+
+template<typename Func>
+const InlineFunctor::Ops InlineFunctor::HeapOps<Func>::kOps =
+{
+    &InlineFunctor::HeapOps<Func>::invoke,
+    &InlineFunctor::HeapOps<Func>::move,
+    &InlineFunctor::HeapOps<Func>::destroy,
+};
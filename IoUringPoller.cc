@@ -0,0 +1,833 @@
+#include "IoUringPoller.h"
+#include "Logger.h"
+#include "Channel.h"
+#include "Buffer.h"
+
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#include <sys/mman.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <signal.h>
+#include <errno.h>
+#include <unistd.h>
+#include <string.h>
+#include <time.h>
+#include <algorithm>
+
+//channel的index_  和EpollPoller相同
+const int kNew = -1;
+const int kAdded = 1;
+const int kDeleted = 2;
+
+const int kNotArmed = -1;
+
+//user_data: 低32位fd  32~39位请求类型  高24位generation
+enum { kOpPoll, kOpRecv, kOpSend };
+const uint32_t kGenerationMask = 0xffffff;
+//POLL_REMOVE ASYNC_CANCEL以及探测用的请求  完成事件直接丢掉
+const uint64_t kIgnoredUserData = ~0ULL;
+//provided buffer ring的组号
+const uint16_t kBufferGroup = 0;
+
+const unsigned IoUringPoller::kDefaultEntries;
+const unsigned IoUringPoller::kRecvBuffers;
+const size_t IoUringPoller::kRecvBlockSize;
+const int IoUringPoller::kMaxLinkedSends;
+
+static uint64_t makeUserData(int fd, int op, uint32_t generation)
+{
+    return static_cast<uint64_t>(generation & kGenerationMask) << 40
+         | static_cast<uint64_t>(op) << 32
+         | static_cast<uint32_t>(fd);
+}
+
+IoUringPoller::IoUringPoller(EventLoop *loop, unsigned entries)
+    : Poller(loop),
+      ringFd_(-1),
+      sqRing_(MAP_FAILED),
+      sqRingSize_(0),
+      cqRing_(MAP_FAILED),
+      cqRingSize_(0),
+      sqes_(static_cast<io_uring_sqe*>(MAP_FAILED)),
+      sqesSize_(0),
+      sqHead_(nullptr),
+      sqTail_(nullptr),
+      sqMask_(0),
+      sqEntries_(0),
+      cqHead_(nullptr),
+      cqTail_(nullptr),
+      cqMask_(0),
+      cqes_(nullptr),
+      sqLocalTail_(0),
+      toSubmit_(0),
+      bufRing_(nullptr),
+      bufRingTail_(0)
+{
+    if(!setup(entries))
+    {
+        LOG_ERROR("io_uring setup error : %d \n", errno);
+        unmapRings();
+        if(ringFd_ >= 0)
+        {
+            ::close(ringFd_);
+            ringFd_ = -1;
+        }
+        return;
+    }
+    //完成模式是可选的 不支持时只做就绪通知
+    if(!setupBufferRing() || !probeMultishotRecv())
+    {
+        LOG_INFO("io_uring completion io is not supported : %d \n", errno);
+        destroyBufferRing();
+    }
+}
+
+IoUringPoller::~IoUringPoller()
+{
+    if(ringFd_ >= 0)
+    {
+        ::close(ringFd_);   //没完成的请求由内核取消
+        ringFd_ = -1;
+    }
+    unmapRings();
+    destroyBufferRing();
+}
+
+bool IoUringPoller::setup(unsigned entries)
+{
+    io_uring_params params;
+    bzero(&params, sizeof params);
+    //multishot poll一个请求可能产生很多cqe  CQ开大一些
+    params.flags = IORING_SETUP_CQSIZE;
+    params.cq_entries = entries * 8;
+    ringFd_ = static_cast<int>(::syscall(__NR_io_uring_setup, entries, &params));
+    if(ringFd_ < 0)
+    {
+        return false;
+    }
+    //等待超时依赖IORING_ENTER_EXT_ARG(5.11)
+    if(!(params.features & IORING_FEAT_EXT_ARG))
+    {
+        errno = ENOSYS;
+        return false;
+    }
+
+    sqRingSize_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cqRingSize_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    const bool singleMmap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if(singleMmap)
+    {
+        sqRingSize_ = cqRingSize_ = std::max(sqRingSize_, cqRingSize_);
+    }
+    sqRing_ = ::mmap(nullptr, sqRingSize_, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE, ringFd_, IORING_OFF_SQ_RING);
+    if(sqRing_ == MAP_FAILED)
+    {
+        return false;
+    }
+    if(singleMmap)
+    {
+        cqRing_ = sqRing_;
+    }
+    else
+    {
+        cqRing_ = ::mmap(nullptr, cqRingSize_, PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_POPULATE, ringFd_, IORING_OFF_CQ_RING);
+        if(cqRing_ == MAP_FAILED)
+        {
+            return false;
+        }
+    }
+    sqesSize_ = params.sq_entries * sizeof(io_uring_sqe);
+    sqes_ = static_cast<io_uring_sqe*>(::mmap(nullptr, sqesSize_, PROT_READ | PROT_WRITE,
+                                    MAP_SHARED | MAP_POPULATE, ringFd_, IORING_OFF_SQES));
+    if(sqes_ == MAP_FAILED)
+    {
+        return false;
+    }
+
+    char *sq = static_cast<char*>(sqRing_);
+    sqHead_ = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+    sqTail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    sqMask_ = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    sqEntries_ = params.sq_entries;
+    //SQ的下标数组和sqes一一对应 之后不用再改
+    unsigned *array = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+    for(unsigned i = 0; i < sqEntries_; ++i)
+    {
+        array[i] = i;
+    }
+    sqLocalTail_ = *sqTail_;
+
+    char *cq = static_cast<char*>(cqRing_);
+    cqHead_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    cqTail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    cqMask_ = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    cqes_ = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+    return true;
+}
+
+void IoUringPoller::unmapRings()
+{
+    if(sqes_ != MAP_FAILED)
+    {
+        ::munmap(sqes_, sqesSize_);
+        sqes_ = static_cast<io_uring_sqe*>(MAP_FAILED);
+    }
+    if(cqRing_ != MAP_FAILED && cqRing_ != sqRing_)
+    {
+        ::munmap(cqRing_, cqRingSize_);
+    }
+    cqRing_ = MAP_FAILED;
+    if(sqRing_ != MAP_FAILED)
+    {
+        ::munmap(sqRing_, sqRingSize_);
+        sqRing_ = MAP_FAILED;
+    }
+}
+
+//provided buffer ring(5.19): 一组缓冲块交给内核 recv时由内核挑一块放数据 cqe里带回块的id
+bool IoUringPoller::setupBufferRing()
+{
+    const size_t ringBytes = kRecvBuffers * sizeof(io_uring_buf);
+    void *ring = ::mmap(nullptr, ringBytes, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(ring == MAP_FAILED)
+    {
+        return false;
+    }
+    bufRing_ = static_cast<io_uring_buf_ring*>(ring);
+
+    io_uring_buf_reg reg;
+    bzero(&reg, sizeof reg);
+    reg.ring_addr = reinterpret_cast<uint64_t>(ring);
+    reg.ring_entries = kRecvBuffers;
+    reg.bgid = kBufferGroup;
+    if(::syscall(__NR_io_uring_register, ringFd_, IORING_REGISTER_PBUF_RING, &reg, 1) < 0)
+    {
+        ::munmap(ring, ringBytes);
+        bufRing_ = nullptr;
+        return false;
+    }
+
+    recvBuffers_.resize(kRecvBuffers, nullptr);
+    for(unsigned bid = 0; bid < kRecvBuffers; ++bid)
+    {
+        size_t capacity = 0;
+        recvBuffers_[bid] = BufferStorage::create(kRecvBlockSize - sizeof(BufferStorage), &capacity);
+        recycleBuffer(bid);
+    }
+    publishBuffers();
+    return true;
+}
+
+//用socketpair实际提交一个multishot recv(6.0) 确认内核支持
+bool IoUringPoller::probeMultishotRecv()
+{
+    int sv[2];
+    if(::socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0, sv) < 0)
+    {
+        return false;
+    }
+    io_uring_sqe *sqe = getSqe();
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = sv[0];
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = kBufferGroup;
+    sqe->user_data = kIgnoredUserData;
+    ::write(sv[1], "x", 1);
+    enter(toSubmit_, 1, 100);
+
+    bool supported = false;
+    unsigned head = *cqHead_;
+    const unsigned tail = __atomic_load_n(cqTail_, __ATOMIC_ACQUIRE);
+    for(; head != tail; ++head)
+    {
+        const io_uring_cqe &cqe = cqes_[head & cqMask_];
+        if(cqe.res == 1 && (cqe.flags & IORING_CQE_F_MORE))
+        {
+            supported = true;
+        }
+        if(cqe.flags & IORING_CQE_F_BUFFER)
+        {
+            recycleBuffer(cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+        }
+    }
+    __atomic_store_n(cqHead_, head, __ATOMIC_RELEASE);
+    publishBuffers();
+
+    //取消探测用的recv 完成事件在之后的poll中被丢掉
+    cancel(kIgnoredUserData);
+    enter(toSubmit_, 0, 0);
+    ::close(sv[0]);
+    ::close(sv[1]);
+    if(!supported)
+    {
+        errno = EINVAL;
+    }
+    return supported;
+}
+
+void IoUringPoller::destroyBufferRing()
+{
+    if(bufRing_ != nullptr)
+    {
+        if(ringFd_ >= 0)
+        {
+            io_uring_buf_reg reg;
+            bzero(&reg, sizeof reg);
+            reg.bgid = kBufferGroup;
+            ::syscall(__NR_io_uring_register, ringFd_, IORING_UNREGISTER_PBUF_RING, &reg, 1);
+        }
+        ::munmap(bufRing_, kRecvBuffers * sizeof(io_uring_buf));
+        bufRing_ = nullptr;
+    }
+    for(BufferStorage *storage : recvBuffers_)
+    {
+        if(storage != nullptr)
+        {
+            storage->release();
+        }
+    }
+    recvBuffers_.clear();
+    for(FdState &st : states_)
+    {
+        for(Completion &c : st.completions)
+        {
+            if(c.storage != nullptr)
+            {
+                c.storage->release();
+            }
+        }
+    }
+}
+
+Timestamp IoUringPoller::poll(int timeoutMs, ChannelList *activeChannels)
+{
+    LOG_DEBUG("func = %s => fd total count= %lu \n",
+            __FUNCTION__, numChannels());
+    flushUpdates();
+
+    //CQ里已经有完成事件就不用等了
+    const bool ready = __atomic_load_n(cqTail_, __ATOMIC_ACQUIRE) != *cqHead_;
+    const unsigned minComplete = (ready || timeoutMs == 0) ? 0 : 1;
+    int ret = 0;
+    if(toSubmit_ > 0 || minComplete > 0)
+    {
+        ret = enter(toSubmit_, minComplete, timeoutMs);
+    }
+    int saveErrno = errno;
+    Timestamp now(Timestamp::now());
+
+    if(ret < 0 && saveErrno != ETIME && saveErrno != EINTR)
+    {
+        errno = saveErrno;
+        LOG_ERROR("IoUringPoller::poll() err!");
+    }
+
+    fillActiveChannels(activeChannels);
+    return now;
+}
+
+//和EpollPoller一样只改channel状态 真正的提交推迟到下一次poll
+void IoUringPoller::updateChannel(Channel *channel)
+{
+    const int index = channel->index();
+    LOG_DEBUG("func = %s => fd = %d events = %d index = %d \n",
+            __FUNCTION__, channel->fd(), channel->events(), channel->index());
+
+    if(index == kNew || index == kDeleted)
+    {
+        if(index == kNew)
+        {
+            addChannel(channel);
+        }
+        channel->set_index(kAdded);
+    }
+    else if(channel->isNoneEvent())
+    {
+        channel->set_index(kDeleted);
+    }
+    markDirty(channel->fd());
+}
+
+//移除后fd可能马上被close再复用  generation加1 旧请求之后产生的cqe都会被丢掉
+void IoUringPoller::removeChannel(Channel *channel)
+{
+    eraseChannel(channel);
+
+    LOG_DEBUG("func = %s => fd = %d events = %d index = %d \n",
+            __FUNCTION__, channel->fd(), channel->events(), channel->index());
+
+    const int fd = channel->fd();
+    FdState &st = state(fd);
+    if(st.armedEvents != kNotArmed)
+    {
+        pollRemove(fd, st);
+        st.armedEvents = kNotArmed;
+    }
+    ++st.generation;
+    st.dirty = false;
+
+    if(st.completionIo)
+    {
+        //按user_data取消 不依赖fd 移除后fd关闭或复用都不影响
+        if(st.recvArmed)
+        {
+            cancel(makeUserData(fd, kOpRecv, st.ioGeneration));
+        }
+        if(st.sendsInFlight > 0)
+        {
+            cancel(makeUserData(fd, kOpSend, st.ioGeneration));
+            RetiredSends retired = { fd, st.ioGeneration, st.sendsInFlight, std::deque<BufferSlice>() };
+            retired.slices.swap(st.sendQueue);
+            retired_.push_back(std::move(retired));
+        }
+        for(Completion &c : st.completions)
+        {
+            if(c.storage != nullptr)
+            {
+                c.storage->release();
+            }
+        }
+        st.completions.clear();
+        st.sendQueue.clear();
+        st.sendOffset = 0;
+        st.sendsInFlight = 0;
+        st.recvArmed = false;
+        st.recvWanted = false;
+        st.completionIo = false;
+        ++st.ioGeneration;
+    }
+    channel->set_index(kNew);
+}
+
+void IoUringPoller::startCompletionIo(Channel *channel)
+{
+    if(channel->index() == kNew)
+    {
+        addChannel(channel);
+    }
+    channel->set_index(kAdded);
+    FdState &st = state(channel->fd());
+    st.completionIo = true;
+    st.recvWanted = true;
+    markDirty(channel->fd());
+}
+
+void IoUringPoller::send(Channel *channel, BufferSlice slice)
+{
+    if(slice.empty())
+    {
+        return;
+    }
+    FdState &st = state(channel->fd());
+    st.sendQueue.push_back(std::move(slice));
+    markDirty(channel->fd());
+}
+
+std::vector<IoUringPoller::Completion>& IoUringPoller::takeCompletions(int fd)
+{
+    //回调里可能注册新的fd使states_扩容 先换出来
+    taken_.clear();
+    taken_.swap(state(fd).completions);
+    return taken_;
+}
+
+IoUringPoller::FdState& IoUringPoller::state(int fd)
+{
+    const size_t index = static_cast<size_t>(fd);
+    if(index >= states_.size())
+    {
+        FdState init = FdState();
+        init.armedEvents = kNotArmed;
+        states_.resize(std::max(index + 1, states_.size() * 2), init);
+    }
+    return states_[index];
+}
+
+void IoUringPoller::markDirty(int fd)
+{
+    FdState &st = state(fd);
+    if(!st.dirty)
+    {
+        st.dirty = true;
+        dirtyFds_.push_back(fd);
+    }
+}
+
+void IoUringPoller::flushUpdates()
+{
+    for(int fd : dirtyFds_)
+    {
+        FdState &st = states_[fd];
+        if(!st.dirty)   //中途被removeChannel了
+        {
+            continue;
+        }
+        st.dirty = false;
+
+        if(st.completionIo)
+        {
+            if(st.recvWanted && !st.recvArmed)
+            {
+                submitRecv(fd, st);
+            }
+            //上一批send全部回来之后才提交下一批 保证顺序
+            if(st.sendsInFlight == 0 && !st.sendQueue.empty())
+            {
+                submitSends(fd, st);
+            }
+        }
+
+        Channel *channel = channels_[fd];
+        int wanted = kNotArmed;
+        if(channel->index() == kAdded && !channel->isNoneEvent())
+        {
+            wanted = channel->events();
+        }
+        if(st.armedEvents == wanted)
+        {
+            continue;
+        }
+        if(st.armedEvents != kNotArmed)
+        {
+            pollRemove(fd, st);
+            st.armedEvents = kNotArmed;
+        }
+        if(wanted != kNotArmed)
+        {
+            pollAdd(fd, st, wanted);
+        }
+    }
+    dirtyFds_.clear();
+}
+
+void IoUringPoller::pollAdd(int fd, FdState &st, int events)
+{
+    ++st.generation;
+    st.armedEvents = events;
+
+    io_uring_sqe *sqe = getSqe();
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = fd;
+    //poll的事件位和epoll相同  EPOLLET不是poll事件 用来选择multishot
+    sqe->poll32_events = static_cast<uint32_t>(events & ~EPOLLET);
+    sqe->len = (events & EPOLLET) ? IORING_POLL_ADD_MULTI : 0;
+    sqe->user_data = makeUserData(fd, kOpPoll, st.generation);
+}
+
+void IoUringPoller::pollRemove(int fd, const FdState &st)
+{
+    io_uring_sqe *sqe = getSqe();
+    sqe->opcode = IORING_OP_POLL_REMOVE;
+    sqe->fd = -1;
+    sqe->addr = makeUserData(fd, kOpPoll, st.generation);
+    sqe->user_data = kIgnoredUserData;
+}
+
+//multishot recv: 一直有效 每收到一段数据产生一个cqe 数据在内核挑的provided buffer里
+void IoUringPoller::submitRecv(int fd, FdState &st)
+{
+    st.recvArmed = true;
+    io_uring_sqe *sqe = getSqe();
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = fd;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = kBufferGroup;
+    sqe->user_data = makeUserData(fd, kOpRecv, st.ioGeneration);
+}
+
+//队列前面的slice每个一个send 用IOSQE_IO_LINK串起来按顺序执行
+//短写不算失败 不会打断链 后面的send照样发出去 字节流中间就缺了一段
+//所以带MSG_WAITALL(6.0): 内核等socket可写后接着发完 只有出错才结束 这时res是已发的字节数
+//链断开 后面的send以-ECANCELED结束 等这一批都回来后从没发的地方重新提交
+void IoUringPoller::submitSends(int fd, FdState &st)
+{
+    int count = std::min(static_cast<int>(st.sendQueue.size()), kMaxLinkedSends);
+    //一条链不能拆到两次提交里
+    if(sqSpace() < static_cast<unsigned>(count))
+    {
+        enter(toSubmit_, 0, 0);
+    }
+    for(int i = 0; i < count; ++i)
+    {
+        const BufferSlice &slice = st.sendQueue[i];
+        const size_t offset = i == 0 ? st.sendOffset : 0;
+        io_uring_sqe *sqe = getSqe();
+        sqe->opcode = IORING_OP_SEND;
+        sqe->fd = fd;
+        sqe->addr = reinterpret_cast<uint64_t>(slice.data() + offset);
+        sqe->len = static_cast<uint32_t>(slice.size() - offset);
+        sqe->msg_flags = MSG_NOSIGNAL | MSG_WAITALL;
+        sqe->flags = i + 1 < count ? IOSQE_IO_LINK : 0;
+        sqe->user_data = makeUserData(fd, kOpSend, st.ioGeneration);
+    }
+    st.sendsInFlight = count;
+}
+
+void IoUringPoller::cancel(uint64_t userData)
+{
+    io_uring_sqe *sqe = getSqe();
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->fd = -1;
+    sqe->addr = userData;
+    sqe->cancel_flags = IORING_ASYNC_CANCEL_ALL;
+    sqe->user_data = kIgnoredUserData;
+}
+
+void IoUringPoller::recycleBuffer(unsigned bid)
+{
+    BufferStorage *storage = recvBuffers_[bid];
+    //C++里__DECLARE_FLEX_ARRAY展开后bufs的偏移不是0 按ABI直接从ring开头取
+    io_uring_buf *bufs = reinterpret_cast<io_uring_buf*>(bufRing_);
+    io_uring_buf &buf = bufs[bufRingTail_ & (kRecvBuffers - 1)];
+    //前面留出kCheapPrepend 交给Buffer后可以直接prepend
+    buf.addr = reinterpret_cast<uint64_t>(storage->data() + Buffer::kCheapPrepend);
+    buf.len = static_cast<uint32_t>(storage->blockSize - sizeof(BufferStorage) - Buffer::kCheapPrepend);
+    buf.bid = static_cast<uint16_t>(bid);
+    ++bufRingTail_;
+}
+
+void IoUringPoller::publishBuffers()
+{
+    __atomic_store_n(&bufRing_->tail, static_cast<uint16_t>(bufRingTail_), __ATOMIC_RELEASE);
+}
+
+io_uring_sqe* IoUringPoller::getSqe()
+{
+    //SQ满了先提交一批
+    if(sqSpace() == 0)
+    {
+        enter(toSubmit_, 0, 0);
+    }
+    io_uring_sqe *sqe = &sqes_[sqLocalTail_ & sqMask_];
+    bzero(sqe, sizeof *sqe);
+    ++sqLocalTail_;
+    ++toSubmit_;
+    return sqe;
+}
+
+unsigned IoUringPoller::sqSpace() const
+{
+    return sqEntries_ - (sqLocalTail_ - __atomic_load_n(sqHead_, __ATOMIC_ACQUIRE));
+}
+
+int IoUringPoller::enter(unsigned toSubmit, unsigned minComplete, int timeoutMs)
+{
+    __atomic_store_n(sqTail_, sqLocalTail_, __ATOMIC_RELEASE);
+
+    unsigned flags = 0;
+    io_uring_getevents_arg arg;
+    bzero(&arg, sizeof arg);
+    timespec ts;
+    if(minComplete > 0)
+    {
+        flags |= IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG;
+        arg.sigmask_sz = _NSIG / 8;
+        if(timeoutMs >= 0)
+        {
+            ts.tv_sec = timeoutMs / 1000;
+            ts.tv_nsec = static_cast<long>(timeoutMs % 1000) * 1000 * 1000;
+            arg.ts = reinterpret_cast<uint64_t>(&ts);
+        }
+    }
+    int ret = static_cast<int>(::syscall(__NR_io_uring_enter, ringFd_, toSubmit, minComplete, flags,
+                                        minComplete > 0 ? &arg : nullptr,
+                                        minComplete > 0 ? sizeof arg : 0));
+    if(ret >= 0)
+    {
+        toSubmit_ -= std::min(toSubmit_, static_cast<unsigned>(ret));
+    }
+    else if(errno == ETIME || errno == EINTR)
+    {
+        //超时或被信号打断时请求也已经提交了
+        toSubmit_ = 0;
+    }
+    return ret;
+}
+
+void IoUringPoller::fillActiveChannels(ChannelList *activeChannels)
+{
+    const size_t first = activeChannels->size();
+    unsigned head = *cqHead_;
+    const unsigned tail = __atomic_load_n(cqTail_, __ATOMIC_ACQUIRE);
+    for(; head != tail; ++head)
+    {
+        const io_uring_cqe &cqe = cqes_[head & cqMask_];
+        if(cqe.user_data == kIgnoredUserData)
+        {
+            if(bufRing_ != nullptr && (cqe.flags & IORING_CQE_F_BUFFER))
+            {
+                recycleBuffer(cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+            }
+            continue;
+        }
+        const int op = static_cast<int>((cqe.user_data >> 32) & 0xff);
+        if(op == kOpRecv)
+        {
+            handleRecv(cqe, activeChannels);
+            continue;
+        }
+        if(op == kOpSend)
+        {
+            handleSend(cqe, activeChannels);
+            continue;
+        }
+
+        const int fd = static_cast<int>(static_cast<uint32_t>(cqe.user_data));
+        const uint32_t generation = static_cast<uint32_t>(cqe.user_data >> 40);
+        FdState &st = states_[fd];
+        //fd已经移除或者关注的事件改过 这是旧请求的cqe
+        if((st.generation & kGenerationMask) != generation || st.armedEvents == kNotArmed)
+        {
+            continue;
+        }
+        //单次poll已经触发 或multishot被内核终止  下一次poll前按需重新提交
+        if(!(cqe.flags & IORING_CQE_F_MORE))
+        {
+            st.armedEvents = kNotArmed;
+            markDirty(fd);
+        }
+        if(cqe.res > 0)
+        {
+            report(fd, st, cqe.res, activeChannels);
+        }
+    }
+    __atomic_store_n(cqHead_, head, __ATOMIC_RELEASE);
+    if(bufRing_ != nullptr)
+    {
+        publishBuffers();
+    }
+
+    for(size_t i = first; i < activeChannels->size(); ++i)
+    {
+        states_[(*activeChannels)[i]->fd()].reported = false;
+    }
+}
+
+void IoUringPoller::handleRecv(const io_uring_cqe &cqe, ChannelList *activeChannels)
+{
+    const int fd = static_cast<int>(static_cast<uint32_t>(cqe.user_data));
+    const uint32_t generation = static_cast<uint32_t>(cqe.user_data >> 40);
+    FdState &st = states_[fd];
+    const bool current = st.completionIo && (st.ioGeneration & kGenerationMask) == generation;
+
+    BufferStorage *storage = nullptr;
+    if(cqe.flags & IORING_CQE_F_BUFFER)
+    {
+        const unsigned bid = cqe.flags >> IORING_CQE_BUFFER_SHIFT;
+        if(current && cqe.res > 0)
+        {
+            //收到数据的块交出去 ring里换一块新的
+            storage = recvBuffers_[bid];
+            size_t capacity = 0;
+            recvBuffers_[bid] = BufferStorage::create(kRecvBlockSize - sizeof(BufferStorage), &capacity);
+        }
+        recycleBuffer(bid);
+    }
+    if(!current)
+    {
+        return;
+    }
+
+    if(!(cqe.flags & IORING_CQE_F_MORE))
+    {
+        st.recvArmed = false;
+        //-ENOBUFS: ring里的块暂时用完了 重新提交即可
+        if(cqe.res > 0 || cqe.res == -ENOBUFS)
+        {
+            markDirty(fd);
+        }
+        else
+        {
+            st.recvWanted = false;
+        }
+    }
+    if(cqe.res == -ENOBUFS)
+    {
+        return;
+    }
+    Completion c = { Completion::kRecv, cqe.res, storage };
+    st.completions.push_back(c);
+    report(fd, st, Channel::kCompletionEvent, activeChannels);
+}
+
+void IoUringPoller::handleSend(const io_uring_cqe &cqe, ChannelList *activeChannels)
+{
+    const int fd = static_cast<int>(static_cast<uint32_t>(cqe.user_data));
+    const uint32_t generation = static_cast<uint32_t>(cqe.user_data >> 40);
+    FdState &st = states_[fd];
+    if(!st.completionIo || (st.ioGeneration & kGenerationMask) != generation)
+    {
+        //channel移除前提交的send 全部回来后释放数据
+        for(auto it = retired_.begin(); it != retired_.end(); ++it)
+        {
+            if(it->fd == fd && (it->ioGeneration & kGenerationMask) == generation)
+            {
+                if(--it->sendsInFlight == 0)
+                {
+                    retired_.erase(it);
+                }
+                break;
+            }
+        }
+        return;
+    }
+
+    --st.sendsInFlight;
+    if(cqe.res > 0)
+    {
+        //链上的send按顺序完成 从队列头开始扣掉发送的字节
+        size_t sent = static_cast<size_t>(cqe.res);
+        while(sent > 0)
+        {
+            const size_t left = st.sendQueue.front().size() - st.sendOffset;
+            if(sent < left)
+            {
+                st.sendOffset += sent;
+                break;
+            }
+            sent -= left;
+            st.sendOffset = 0;
+            st.sendQueue.pop_front();
+        }
+    }
+    else if(cqe.res < 0 && cqe.res != -ECANCELED)
+    {
+        //连接已经出错 剩下的数据不再发送
+        st.sendQueue.clear();
+        st.sendOffset = 0;
+    }
+    if(st.sendsInFlight == 0 && !st.sendQueue.empty())
+    {
+        markDirty(fd);
+    }
+    //前面的send出错造成的-ECANCELED不用上报 数据还在队列里
+    if(cqe.res == -ECANCELED)
+    {
+        return;
+    }
+    Completion c = { Completion::kSend, cqe.res, nullptr };
+    st.completions.push_back(c);
+    report(fd, st, Channel::kCompletionEvent, activeChannels);
+}
+
+void IoUringPoller::report(int fd, FdState &st, int revents, ChannelList *activeChannels)
+{
+    Channel *channel = channels_[fd];
+    //multishot一轮里可能有多个cqe 合并成一次事件
+    if(st.reported)
+    {
+        channel->set_revents(channel->revents() | revents);
+    }
+    else
+    {
+        st.reported = true;
+        channel->set_revents(revents);
+        activeChannels->push_back(channel);
+    }
+}
@@ -0,0 +1,155 @@
+#pragma once
+
+#include "Poller.h"
+#include "BufferSlice.h"
+
+#include <deque>
+#include <vector>
+#include <stdint.h>
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+struct io_uring_buf_ring;
+
+/*
+io_uring实现的poller  不依赖liburing 直接用系统调用
+io_uring_setup: 创建io_uring实例  提交队列SQ和完成队列CQ通过mmap和内核共享
+io_uring_enter: 提交SQ中的请求  同时可以等待CQ中的完成事件
+IORING_OP_POLL_ADD: 监听fd的就绪事件  完成事件cqe的res就是发生的事件(和epoll的事件位相同)
+
+水平触发的channel用单次poll 事件处理完在下一次poll之前重新提交 fd仍然就绪会马上再通知
+边缘触发的channel用multishot poll 一直有效 每次有新的就绪才产生一个cqe
+关注事件的变化先记下来 下一次poll时和等待一起用一次io_uring_enter提交
+
+完成模式(startCompletionIo): 不再等就绪后自己read/write
+    接收: 每个fd一个multishot recv 内核直接把数据收进provided buffer ring中的缓冲块
+          缓冲块就是BufferStorage 收到数据的块交给Buffer接管 ring里补一块新的
+    发送: send()把slice排进fd的发送队列 下一次poll时队列里的slice用IOSQE_IO_LINK串起来提交
+          每个send带MSG_WAITALL 短写时内核接着发 不会让链上后面的数据先出去
+    结果先存在fd上 channel以kCompletionEvent上报 由TcpConnection用takeCompletions取走
+*/
+class IoUringPoller : public Poller
+{
+public:
+    //完成模式下的一个结果
+    struct Completion
+    {
+        enum Type { kRecv, kSend };
+        Type type;
+        int res;                    //收发的字节数  kRecv时0表示对端关闭  <0为-errno
+        BufferStorage *storage;     //kRecv且res > 0: 数据在data() + Buffer::kCheapPrepend处 持有一个引用
+    };
+
+    IoUringPoller(EventLoop *loop, unsigned entries = kDefaultEntries);
+    ~IoUringPoller() override;
+
+    //内核不支持或禁用了io_uring时为false  newDefaultPoller会换回epoll
+    bool valid() const { return ringFd_ >= 0; }
+    //内核支持provided buffer ring和multishot recv时为true
+    bool completionIoEnabled() const { return bufRing_ != nullptr; }
+
+    Timestamp poll(int timeoutMs, ChannelList *activeChannels) override;
+    void updateChannel(Channel *channel) override;
+    void removeChannel(Channel *channel) override;
+
+    //channel改用完成模式收发 由removeChannel结束
+    void startCompletionIo(Channel *channel);
+    //排进发送队列 数据由slice持有 直到内核发送完成
+    void send(Channel *channel, BufferSlice slice);
+    //取走fd上积累的结果 返回的vector在下一次调用前有效
+    std::vector<Completion>& takeCompletions(int fd);
+
+private:
+    static const unsigned kDefaultEntries = 256;
+    //provided buffer ring的块数(2的幂)和每块的大小(包括BufferStorage头部)
+    static const unsigned kRecvBuffers = 256;
+    static const size_t kRecvBlockSize = 16 * 1024;
+    //一次最多串起来提交的send
+    static const int kMaxLinkedSends = 16;
+
+    //每个fd上提交给内核的请求
+    struct FdState
+    {
+        uint32_t generation;    //每提交一次poll加1 和fd一起放进user_data 用来丢弃过期的cqe
+        int armedEvents;        //正在生效的poll监听的事件  kNotArmed表示没有
+        bool dirty;             //在dirtyFds_中
+        bool reported;          //本轮已经放进activeChannels
+
+        //完成模式
+        uint32_t ioGeneration;  //removeChannel时加1  之前的recv/send结果都作废
+        bool completionIo;
+        bool recvWanted;        //对端关闭或出错后不再提交recv
+        bool recvArmed;         //multishot recv正在生效
+        int sendsInFlight;
+        size_t sendOffset;      //sendQueue.front()已经发送的字节
+        std::deque<BufferSlice> sendQueue;
+        std::vector<Completion> completions;
+    };
+
+    //channel移除时还在内核里的send 数据要留到cqe回来
+    struct RetiredSends
+    {
+        int fd;
+        uint32_t ioGeneration;
+        int sendsInFlight;
+        std::deque<BufferSlice> slices;
+    };
+
+    bool setup(unsigned entries);
+    void unmapRings();
+    bool setupBufferRing();
+    bool probeMultishotRecv();
+    void destroyBufferRing();
+
+    FdState& state(int fd);
+    void markDirty(int fd);
+    //把记录下来的变化写进SQ
+    void flushUpdates();
+    void pollAdd(int fd, FdState &st, int events);
+    void pollRemove(int fd, const FdState &st);
+    void submitRecv(int fd, FdState &st);
+    void submitSends(int fd, FdState &st);
+    void cancel(uint64_t userData);
+    //把第bid块放回provided buffer ring
+    void recycleBuffer(unsigned bid);
+    void publishBuffers();
+
+    io_uring_sqe* getSqe();
+    unsigned sqSpace() const;
+    int enter(unsigned toSubmit, unsigned minComplete, int timeoutMs);
+    //处理CQ中所有的完成事件
+    void fillActiveChannels(ChannelList *activeChannels);
+    void handleRecv(const io_uring_cqe &cqe, ChannelList *activeChannels);
+    void handleSend(const io_uring_cqe &cqe, ChannelList *activeChannels);
+    void report(int fd, FdState &st, int revents, ChannelList *activeChannels);
+
+    int ringFd_;
+
+    void *sqRing_;
+    size_t sqRingSize_;
+    void *cqRing_;
+    size_t cqRingSize_;
+    io_uring_sqe *sqes_;
+    size_t sqesSize_;
+
+    unsigned *sqHead_;
+    unsigned *sqTail_;
+    unsigned sqMask_;
+    unsigned sqEntries_;
+    unsigned *cqHead_;
+    unsigned *cqTail_;
+    unsigned cqMask_;
+    io_uring_cqe *cqes_;
+
+    unsigned sqLocalTail_;  //已经写好还没提交的sqe到这里为止
+    unsigned toSubmit_;
+
+    io_uring_buf_ring *bufRing_;
+    unsigned bufRingTail_;
+    std::vector<BufferStorage*> recvBuffers_;  //下标是buffer id
+
+    std::vector<FdState> states_;   //下标是fd
+    std::vector<int> dirtyFds_;
+    std::vector<RetiredSends> retired_;
+    std::vector<Completion> taken_;
+};
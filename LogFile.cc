@@ -0,0 +1,233 @@
+#include "LogFile.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+
+const size_t LogFile::kDefaultSegmentSize;
+
+LogFile::LogFile(const std::string &basename,
+                size_t rollSize,
+                bool threadSafe,
+                int flushInterval,
+                int rollInterval,
+                size_t segmentSize)
+    :   basename_(basename),
+        rollSize_(rollSize),
+        flushInterval_(flushInterval),
+        rollInterval_(rollInterval),
+        segmentSize_(segmentSize),
+        mutex_(threadSafe ? new std::mutex : nullptr),
+        fd_(-1),
+        segment_(nullptr),
+        segmentOffset_(0),
+        written_(0),
+        flushedUntil_(0),
+        startOfPeriod_(0),
+        lastRoll_(0),
+        lastFlush_(0)
+{
+    rollFileUnlocked();
+}
+
+LogFile::~LogFile()
+{
+    closeFile();
+}
+
+void LogFile::append(const char *logline, size_t len)
+{
+    if(mutex_)
+    {
+        std::unique_lock<std::mutex> lock(*mutex_);
+        appendUnlocked(logline, len);
+    }
+    else
+    {
+        appendUnlocked(logline, len);
+    }
+}
+
+void LogFile::flush()
+{
+    if(mutex_)
+    {
+        std::unique_lock<std::mutex> lock(*mutex_);
+        flushUnlocked();
+    }
+    else
+    {
+        flushUnlocked();
+    }
+}
+
+bool LogFile::rollFile()
+{
+    if(mutex_)
+    {
+        std::unique_lock<std::mutex> lock(*mutex_);
+        return rollFileUnlocked();
+    }
+    return rollFileUnlocked();
+}
+
+void LogFile::appendUnlocked(const char *logline, size_t len)
+{
+    if(segment_ == nullptr && !rollFileUnlocked())
+    {
+        return; //打开文件失败 每秒重试一次
+    }
+
+    while(len > 0)
+    {
+        size_t pos = written_ - segmentOffset_;
+        if(pos == segmentSize_)
+        {
+            //当前段写满 映射下一个段
+            if(!mapSegment(segmentOffset_ + segmentSize_))
+            {
+                return;
+            }
+            pos = 0;
+        }
+        size_t n = len < segmentSize_ - pos ? len : segmentSize_ - pos;
+        memcpy(segment_ + pos, logline, n);
+        written_ += n;
+        logline += n;
+        len -= n;
+    }
+
+    //time()走vDSO 每次append都检查 日志很少时也能按时flush
+    time_t now = ::time(NULL);
+    if(written_ > rollSize_ || now / rollInterval_ * rollInterval_ != startOfPeriod_)
+    {
+        rollFileUnlocked();
+    }
+    else if(now - lastFlush_ > flushInterval_)
+    {
+        flushUnlocked();
+    }
+}
+
+void LogFile::flushUnlocked()
+{
+    if(segment_ == nullptr)
+    {
+        return;
+    }
+    //只msync当前段中还没有flush过的部分 之前的段在unmap前已经处理过
+    size_t begin = flushedUntil_ > segmentOffset_ ? flushedUntil_ - segmentOffset_ : 0;
+    size_t pageSize = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+    begin = begin / pageSize * pageSize;
+    size_t end = written_ - segmentOffset_;
+    if(end > begin)
+    {
+        ::msync(segment_ + begin, end - begin, MS_ASYNC);
+    }
+    ::fdatasync(fd_);
+    flushedUntil_ = written_;
+    lastFlush_ = ::time(NULL);
+}
+
+bool LogFile::rollFileUnlocked()
+{
+    time_t now = ::time(NULL);
+    //同一秒内不重复滚动 否则文件名会重复  失败了也等到下一秒再试 不在每次append上重试
+    if(now <= lastRoll_)
+    {
+        return false;
+    }
+    lastRoll_ = now;
+
+    std::string filename = getLogFileName(basename_, now);
+    closeFile();
+    fd_ = ::open(filename.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if(fd_ < 0)
+    {
+        fprintf(stderr, "LogFile::rollFile open %s failed %d\n", filename.c_str(), errno);
+        return false;
+    }
+    written_ = 0;
+    flushedUntil_ = 0;
+    lastFlush_ = now;
+    startOfPeriod_ = now / rollInterval_ * rollInterval_;
+    return mapSegment(0);
+}
+
+bool LogFile::mapSegment(size_t offset)
+{
+    unmapSegment();
+
+    //fallocate预分配磁盘空间 写入mmap的页时不会因为分配块而阻塞或者SIGBUS
+    off_t fileOffset = static_cast<off_t>(offset);
+    off_t length = static_cast<off_t>(segmentSize_);
+    if(::fallocate(fd_, 0, fileOffset, length) < 0)
+    {
+        //文件系统不支持fallocate 退化为ftruncate扩展文件
+        if(errno != EOPNOTSUPP || ::ftruncate(fd_, fileOffset + length) < 0)
+        {
+            fprintf(stderr, "LogFile::mapSegment fallocate failed %d\n", errno);
+            return false;
+        }
+    }
+
+    void *addr = ::mmap(NULL, segmentSize_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, fileOffset);
+    if(addr == MAP_FAILED)
+    {
+        fprintf(stderr, "LogFile::mapSegment mmap failed %d\n", errno);
+        return false;
+    }
+    segment_ = static_cast<char*>(addr);
+    segmentOffset_ = offset;
+    return true;
+}
+
+void LogFile::unmapSegment()
+{
+    if(segment_ != nullptr)
+    {
+        //写满的段交给内核异步回写
+        ::msync(segment_, written_ - segmentOffset_, MS_ASYNC);
+        ::munmap(segment_, segmentSize_);
+        segment_ = nullptr;
+    }
+}
+
+void LogFile::closeFile()
+{
+    if(fd_ < 0)
+    {
+        return;
+    }
+    unmapSegment();
+    //去掉预分配但没有写入的部分
+    if(::ftruncate(fd_, static_cast<off_t>(written_)) < 0)
+    {
+        fprintf(stderr, "LogFile::closeFile ftruncate failed %d\n", errno);
+    }
+    ::fdatasync(fd_);
+    ::close(fd_);
+    fd_ = -1;
+}
+
+//basename.20261018-065526.1234.log
+std::string LogFile::getLogFileName(const std::string &basename, time_t now)
+{
+    std::string filename;
+    filename.reserve(basename.size() + 64);
+    filename = basename;
+
+    char timebuf[32];
+    struct tm tm;
+    localtime_r(&now, &tm);
+    strftime(timebuf, sizeof timebuf, ".%Y%m%d-%H%M%S.", &tm);
+    filename += timebuf;
+
+    char pidbuf[32];
+    snprintf(pidbuf, sizeof pidbuf, "%d.log", ::getpid());
+    filename += pidbuf;
+    return filename;
+}
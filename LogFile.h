@@ -0,0 +1,67 @@
+#pragma once
+
+#include "noncopyable.h"
+
+#include <string>
+#include <mutex>
+#include <memory>
+#include <time.h>
+
+/*
+基于mmap的滚动日志文件
+    每次用fallocate预分配一个段(segmentSize) 并把这个段mmap到内存中 写日志只是一次memcpy 没有系统调用
+    当前段写满后预分配并映射下一个段
+    文件大小超过rollSize 或者跨过rollInterval秒的时间边界时 滚动到新文件
+    按flushInterval秒定期msync + fdatasync 而不是每行都flush
+    关闭文件时ftruncate掉预分配但未写入的部分
+可以直接作为Logger的输出  threadSafe为false时只能在一个线程中使用(比如AsyncLogging的后端)
+*/
+class LogFile : noncopyable
+{
+public:
+    static const size_t kDefaultSegmentSize = 64 * 1024 * 1024;
+
+    LogFile(const std::string &basename,
+            size_t rollSize,
+            bool threadSafe = true,
+            int flushInterval = 3,
+            int rollInterval = 60 * 60 * 24,
+            size_t segmentSize = kDefaultSegmentSize);
+    ~LogFile();
+
+    void append(const char *logline, size_t len);
+    void flush();
+    //滚动到新文件 成功返回true  同一秒内只滚动一次
+    bool rollFile();
+
+    size_t writtenBytes() const { return written_; }
+
+private:
+    void appendUnlocked(const char *logline, size_t len);
+    void flushUnlocked();
+    bool rollFileUnlocked();
+    void closeFile();
+    //预分配并映射从offset开始的一个段
+    bool mapSegment(size_t offset);
+    void unmapSegment();
+
+    static std::string getLogFileName(const std::string &basename, time_t now);
+
+    const std::string basename_;
+    const size_t rollSize_;
+    const int flushInterval_;
+    const int rollInterval_;
+    const size_t segmentSize_;
+
+    std::unique_ptr<std::mutex> mutex_;
+
+    int fd_;
+    char *segment_;         //当前映射的段
+    size_t segmentOffset_;  //当前段在文件中的偏移
+    size_t written_;        //文件中已经写入的字节数
+    size_t flushedUntil_;   //已经msync过的位置
+
+    time_t startOfPeriod_;  //当前文件所在的滚动周期的起点
+    time_t lastRoll_;       //最后一次尝试滚动的时间 不论成功与否
+    time_t lastFlush_;
+};
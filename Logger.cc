@@ -1,6 +1,47 @@
 #include "Logger.h"
 #include "Timestamp.h"
-#include <iostream>
+#include <stdio.h>
+#include <time.h>
+
+static void defaultOutput(const char *msg, size_t len)
+{
+    fwrite(msg, 1, len, stdout);
+    fflush(stdout);
+}
+
+static void defaultFlush()
+{
+    fflush(stdout);
+}
+
+static Logger::OutputFunc g_output = defaultOutput;
+static Logger::FlushFunc g_flush = defaultFlush;
+
+std::atomic<int> Logger::s_logLevel_(INFO);
+
+//每个线程缓存当前这一秒格式化好的时间  同一秒内的日志不再调用localtime
+static __thread time_t t_lastSecond = 0;
+static __thread char t_time[64];
+
+static const char* formatTime()
+{
+    int64_t micros = Timestamp::now().microSecondsSinceEpoch();
+    time_t seconds = static_cast<time_t>(micros / Timestamp::kMicroSecondsPerSecond);
+    if(seconds != t_lastSecond)
+    {
+        t_lastSecond = seconds;
+        struct tm tm_time;
+        localtime_r(&seconds, &tm_time);
+        snprintf(t_time, sizeof t_time, "%4d/%02d/%02d %02d:%02d:%02d",
+            tm_time.tm_year + 1900,
+            tm_time.tm_mon + 1,
+            tm_time.tm_mday,
+            tm_time.tm_hour,
+            tm_time.tm_min,
+            tm_time.tm_sec);
+    }
+    return t_time;
+}
 
 //获取唯一的日志实例对象
 Logger& Logger::instance()
@@ -9,34 +50,54 @@ Logger& Logger::instance()
     return logger;
 }
 
-//设置日志级别
-void Logger::setLogLevel(int level)
+void Logger::setOutput(OutputFunc out)
+{
+    g_output = out;
+}
+
+void Logger::setFlush(FlushFunc flush)
 {
-    loglevel_ = level;
+    g_flush = flush;
 }
 
-//写日志
-void Logger::log(std::string msg)
+//写日志  先把整行日志格式化到栈上的缓冲区 再一次性交给output
+void Logger::log(int level, const char *msg)
 {
-    switch (loglevel_)
+    const char *name = "";
+    switch (level)
     {
     case INFO:
-        std::cout << "[INFO]";
+        name = "[INFO]";
+        break;
+    case WARN:
+        name = "[WARN]";
         break;
     case ERROR:
-        std::cout << "[ERROE]";
+        name = "[ERROE]";
         break;
     case FATAL:
-        std::cout << "[FATAL]";
+        name = "[FATAL]";
         break;
     case DEBUG:
-        std::cout << "[DEBUG]";
+        name = "[DEBUG]";
         break;    
     default:
         break;
     }
 
     //打印时间和msg
-    std::cout << "time : " << Timestamp::now().toString() << " : " << msg << std::endl;
+    char line[1280];
+    int n = snprintf(line, sizeof line, "%stime : %s : %s\n",
+                    name, formatTime(), msg);
+    if(n >= static_cast<int>(sizeof line))
+    {
+        n = sizeof line - 1;
+        line[n - 1] = '\n';
+    }
+    g_output(line, static_cast<size_t>(n));
+    if(level == FATAL)
+    {
+        g_flush();
+    }
 
-}
\ No newline at end of file
+}
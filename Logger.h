@@ -2,80 +2,88 @@
 
 #include "noncopyable.h"
 #include <string>
+#include <atomic>
+#include <stdio.h>
+#include <stdlib.h>
+
+//定义日志的级别  DEBUG INFO WARN ERROR FATAL  从低到高
+enum LogLevel
+{
+    DEBUG,  //调试信息
+    INFO,   //普通信息
+    WARN,   //警告信息
+    ERROR,  //错误信息
+    FATAL,  //core信息
+};
+
+//编译期的最低日志级别 低于该级别的日志调用在编译期就被消除
+//定义了MUDEBUD时保留DEBUG日志 否则从INFO开始
+#ifndef MYMUDUO_MIN_LOG_LEVEL
+#ifdef MUDEBUD
+#define MYMUDUO_MIN_LOG_LEVEL DEBUG
+#else
+#define MYMUDUO_MIN_LOG_LEVEL INFO
+#endif
+#endif
 
 //LOG_INFO("%s %d", arg1, arg2)
 //__VA_ARGS__获取可变参的宏
 //logmsgFormat：字符串，后面...是可变参
 //为了防止造成意想不到的错误用do-while(0)
-
-#define LOG_INFO(logmsgFormat, ...) \
+//日志级别没有开启时只有一次分支判断 不会格式化字符串
+#define LOG_LEVEL_IMPL(level, logmsgFormat, ...) \
     do \
     { \
-        Logger &logger = Logger::instance(); \
-        logger.setLogLevel(INFO); \
-        char buf[1024] = {0}; \
-        snprintf(buf, 1024, logmsgFormat, ##__VA_ARGS__); \
-        logger.log(buf); \
+        if((level) >= MYMUDUO_MIN_LOG_LEVEL && Logger::isEnabled(level)) \
+        { \
+            char buf[1024]; \
+            snprintf(buf, sizeof buf, logmsgFormat, ##__VA_ARGS__); \
+            Logger::instance().log(level, buf); \
+        } \
     } while(0)
 
-#define LOG_ERROR(logmsgFormat, ...) \
-    do \
-    { \
-        Logger &logger = Logger::instance(); \
-        logger.setLogLevel(ERROR); \
-        char buf[1024] = {0}; \
-        snprintf(buf, 1024, logmsgFormat, ##__VA_ARGS__); \
-        logger.log(buf); \
-    } while(0)
+#define LOG_DEBUG(logmsgFormat, ...) LOG_LEVEL_IMPL(DEBUG, logmsgFormat, ##__VA_ARGS__)
+#define LOG_INFO(logmsgFormat, ...) LOG_LEVEL_IMPL(INFO, logmsgFormat, ##__VA_ARGS__)
+#define LOG_WARN(logmsgFormat, ...) LOG_LEVEL_IMPL(WARN, logmsgFormat, ##__VA_ARGS__)
+#define LOG_ERROR(logmsgFormat, ...) LOG_LEVEL_IMPL(ERROR, logmsgFormat, ##__VA_ARGS__)
 
 #define LOG_FATAL(logmsgFormat, ...) \
     do \
     { \
-        Logger &logger = Logger::instance(); \
-        logger.setLogLevel(FATAL); \
-        char buf[1024] = {0}; \
-        snprintf(buf, 1024, logmsgFormat, ##__VA_ARGS__); \
-        logger.log(buf); \
+        char buf[1024]; \
+        snprintf(buf, sizeof buf, logmsgFormat, ##__VA_ARGS__); \
+        Logger::instance().log(FATAL, buf); \
         exit(-1); \
     } while(0)
 
-#ifdef MUDEBUD
-#define LOG_DEBUG(logmsgFormat, ...) \
-    do \
-    { \
-        Logger &logger = Logger::instance(); \
-        logger.setLogLevel(DEBUG); \
-        char buf[1024] = {0}; \
-        snprintf(buf, 1024, logmsgFormat, ##__VA_ARGS__); \
-        logger.log(buf); \
-    } while(0)
-#else
-    #define LOG_DEBUG(logmsgFormat, ...)
-#endif
-
-//定义日志的级别  INFO ERROR FATAL DEBUG
-enum LogLevel
-{
-    INFO,   //普通信息
-    ERROR,  //错误信息
-    FATAL,  //core信息
-    DEBUG,  //调试信息
-};
-
 //输出个日志类
 class Logger : noncopyable
 {
 public:
+    //日志的输出目的地 默认输出到stdout  可以替换成AsyncLogging::append
+    using OutputFunc = void (*)(const char *msg, size_t len);
+    using FlushFunc = void (*)();
+
     //获取唯一的日志实例对象
     static Logger& instance();
-    //设置日志级别
-    void setLogLevel(int level);
+
+    //需要在其他线程开始写日志之前设置
+    static void setOutput(OutputFunc out);
+    static void setFlush(FlushFunc flush);
+
+    //设置运行期的日志级别 低于level的日志不输出 默认INFO  线程安全
+    static void setLogLevel(int level) { s_logLevel_.store(level, std::memory_order_relaxed); }
+    static int logLevel() { return s_logLevel_.load(std::memory_order_relaxed); }
+    static bool isEnabled(int level)
+    {
+        return __builtin_expect(level >= s_logLevel_.load(std::memory_order_relaxed), 0);
+    }
+
     //写日志
-    void log(std::string msg);
+    void log(int level, const char *msg);
     
 private:
-    int loglevel_;
+    static std::atomic<int> s_logLevel_;
     Logger() {}
     
 };
-
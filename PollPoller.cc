@@ -0,0 +1,110 @@
+#include "PollPoller.h"
+#include "Logger.h"
+#include "Channel.h"
+
+#include <errno.h>
+
+//channel的index_  不在pollfds_中
+const int kNew = -1;
+
+PollPoller::PollPoller(EventLoop *loop)
+    : Poller(loop)
+{
+}
+
+PollPoller::~PollPoller() = default;
+
+Timestamp PollPoller::poll(int timeoutMs, ChannelList *activeChannels)
+{
+    LOG_DEBUG("func = %s => fd total count= %lu \n",
+            __FUNCTION__, numChannels());
+    int numEvents = ::poll(pollfds_.data(), pollfds_.size(), timeoutMs);
+    int saveErrno = errno;
+    Timestamp now(Timestamp::now());
+
+    if(numEvents > 0)
+    {
+        LOG_DEBUG(" %d events happend \n", numEvents);
+        fillActiveChannels(numEvents, activeChannels);
+    }
+    else if(numEvents == 0)
+    {
+        LOG_DEBUG("%s timeout! \n", __FUNCTION__);
+    }
+    else if(saveErrno != EINTR)
+    {
+        errno = saveErrno;
+        LOG_ERROR("PollPoller::poll() err!");
+    }
+    return now;
+}
+
+//poll返回的是有事件的fd个数 找够了就不用再往后扫
+void PollPoller::fillActiveChannels(int numEvents, ChannelList *activeChannels) const
+{
+    for(auto it = pollfds_.begin(); it != pollfds_.end() && numEvents > 0; ++it)
+    {
+        if(it->revents > 0)
+        {
+            --numEvents;
+            Channel *channel = channels_[it->fd];
+            channel->set_revents(it->revents);
+            activeChannels->push_back(channel);
+        }
+    }
+}
+
+//poll没有注册的系统调用 直接改pollfds_ 下一次poll生效
+void PollPoller::updateChannel(Channel *channel)
+{
+    LOG_DEBUG("func = %s => fd = %d events = %d index = %d \n",
+            __FUNCTION__, channel->fd(), channel->events(), channel->index());
+
+    //poll的事件位和epoll相同 高位的EPOLLET被截掉
+    const short events = static_cast<short>(channel->events());
+    if(channel->index() == kNew)
+    {
+        addChannel(channel);
+        pollfd pfd;
+        pfd.fd = channel->fd();
+        pfd.events = events;
+        pfd.revents = 0;
+        pollfds_.push_back(pfd);
+        channel->set_index(static_cast<int>(pollfds_.size()) - 1);
+    }
+    else
+    {
+        pollfd &pfd = pollfds_[channel->index()];
+        pfd.fd = channel->isNoneEvent() ? -channel->fd() - 1 : channel->fd();
+        pfd.events = events;
+        pfd.revents = 0;
+    }
+}
+
+//最后一个pollfd换到被删的位置 被换过来的channel更新index
+void PollPoller::removeChannel(Channel *channel)
+{
+    eraseChannel(channel);
+
+    LOG_DEBUG("func = %s => fd = %d events = %d index = %d \n",
+            __FUNCTION__, channel->fd(), channel->events(), channel->index());
+
+    const int index = channel->index();
+    if(index == kNew)
+    {
+        return;
+    }
+    const size_t last = pollfds_.size() - 1;
+    if(static_cast<size_t>(index) != last)
+    {
+        pollfds_[index] = pollfds_.back();
+        int movedFd = pollfds_[index].fd;
+        if(movedFd < 0)
+        {
+            movedFd = -movedFd - 1;
+        }
+        channels_[movedFd]->set_index(index);
+    }
+    pollfds_.pop_back();
+    channel->set_index(kNew);
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "Poller.h"
+
+#include <vector>
+#include <poll.h>
+
+/*
+poll(2)实现的poller  fd很少的loop用 不需要epoll实例和内核里的红黑树
+每次poll把整个pollfd数组交给内核  fd多了以后比epoll慢
+
+pollfds_是紧凑的数组  channel的index()就是它在pollfds_中的下标 (-1表示不在数组中)
+删除时把最后一个元素换到被删的位置 再修改被换过来的channel的index  O(1)
+关注的事件为空的channel 把fd改成负数(-fd-1) poll会忽略它 下标不变
+
+poll没有边缘触发 EPOLLET会被去掉 边缘触发的连接读写到EAGAIN为止 在水平触发下同样正确
+*/
+class PollPoller : public Poller
+{
+public:
+    PollPoller(EventLoop *loop);
+    ~PollPoller() override;
+
+    Timestamp poll(int timeoutMs, ChannelList *activeChannels) override;
+    void updateChannel(Channel *channel) override;
+    void removeChannel(Channel *channel) override;
+
+private:
+    void fillActiveChannels(int numEvents, ChannelList *activeChannels) const;
+
+    using PollFdList = std::vector<pollfd>;
+    PollFdList pollfds_;
+};
@@ -1,14 +1,41 @@
 #include "Poller.h"
 #include "Channel.h"
 
+#include <algorithm>
+
 Poller::Poller(EventLoop *loop)
-    : ownerLoop_(loop)
+    : ownerLoop_(loop),
+      numChannels_(0)
 {
 }
 
 
 bool Poller::hasChannel(Channel *channel) const
 {
-    auto it = channels_.find(channel->fd());
-    return it != channels_.end() && it->second == channel;
+    const size_t fd = static_cast<size_t>(channel->fd());
+    return fd < channels_.size() && channels_[fd] == channel;
+}
+
+void Poller::addChannel(Channel *channel)
+{
+    const size_t fd = static_cast<size_t>(channel->fd());
+    if(fd >= channels_.size())
+    {
+        channels_.resize(std::max(fd + 1, channels_.size() * 2), nullptr);
+    }
+    if(channels_[fd] == nullptr)
+    {
+        ++numChannels_;
+    }
+    channels_[fd] = channel;
+}
+
+void Poller::eraseChannel(Channel *channel)
+{
+    const size_t fd = static_cast<size_t>(channel->fd());
+    if(fd < channels_.size() && channels_[fd] == channel)
+    {
+        channels_[fd] = nullptr;
+        --numChannels_;
+    }
 }
\ No newline at end of file
@@ -2,7 +2,6 @@
 #include "noncopyable.h"
 #include "Timestamp.h"
 #include <vector>
-#include <unordered_map>
 
 class Channel;
 class EventLoop;
@@ -35,12 +34,20 @@ public:
     static Poller* newDefaultPoller(EventLoop *loop);
 
 protected:
-    //map的key ： sockfd   value: sockfd所属的channel通道
-    using ChannelMap = std::unordered_map<int, Channel*>;
+    //下标是sockfd  value: sockfd所属的channel通道  没有注册的fd为nullptr
+    //fd由内核从小往上分配 用数组比哈希表查找快 也不用计算hash
+    using ChannelMap = std::vector<Channel*>;
+
+    void addChannel(Channel *channel);
+    void eraseChannel(Channel *channel);
+    //已经注册的channel个数
+    size_t numChannels() const { return numChannels_; }
+
     ChannelMap channels_;
 private:
     /* data */
     //定义poller所属的事件循环EventLoop
     EventLoop *ownerLoop_;
+    size_t numChannels_;
 };
 
@@ -7,6 +7,8 @@
 #include <sys/socket.h>
 #include <strings.h>
 #include <netinet/tcp.h>
+#include <linux/filter.h>
+#include <errno.h>
 
 
 
@@ -119,6 +121,31 @@ void Socket::setReusePort(bool on)
     ::setsockopt(sockfd_, SOL_SOCKET, SO_REUSEPORT, &optval, sizeof optval);
 }
 
+void Socket::setDeferAccept(int seconds)
+{
+    ::setsockopt(sockfd_, IPPROTO_TCP, TCP_DEFER_ACCEPT, &seconds, sizeof seconds);
+}
+
+bool Socket::attachReusePortCpuSteering(int numListeners)
+{
+    //A = 当前CPU; A %= numListeners; return A
+    sock_filter code[] = {
+        { BPF_LD | BPF_W | BPF_ABS, 0, 0, static_cast<uint32_t>(SKF_AD_OFF + SKF_AD_CPU) },
+        { BPF_ALU | BPF_MOD | BPF_K, 0, 0, static_cast<uint32_t>(numListeners) },
+        { BPF_RET | BPF_A, 0, 0, 0 },
+    };
+    sock_fprog prog;
+    prog.len = sizeof code / sizeof code[0];
+    prog.filter = code;
+    if(::setsockopt(sockfd_, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &prog, sizeof prog) < 0)
+    {
+        LOG_ERROR("%s : %s : %d  SO_ATTACH_REUSEPORT_CBPF err: %d \n",
+                    __FILE__, __FUNCTION__, __LINE__, errno);
+        return false;
+    }
+    return true;
+}
+
 void Socket::setKeepAlive(bool on)
 {
     int optval = on ? 1 : 0;
@@ -26,6 +26,11 @@ public:
     void setReuseAddr(bool on);
     void setReusePort(bool on);
     void setKeepAlive(bool on);
+    //TCP_DEFER_ACCEPT: 三次握手完成后等对端发来数据(最多约seconds秒)才让accept返回  0表示关闭
+    void setDeferAccept(int seconds);
+    //给这个socket所在的SO_REUSEPORT组挂一个CBPF程序: 连接交给第(处理它的CPU % numListeners)个listen的socket
+    //组里的socket要按listen的顺序和loop对应 失败返回false 内核按四元组哈希分配
+    bool attachReusePortCpuSteering(int numListeners);
 private:
     const int sockfd_;
 
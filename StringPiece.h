@@ -0,0 +1,53 @@
+#pragma once
+
+#include <string.h>
+#include <string>
+
+//不持有内存的字符串视图(C++11没有std::string_view) 只在指向的数据有效期间使用
+class StringPiece
+{
+public:
+    StringPiece()
+        :   ptr_(nullptr), length_(0)
+    {}
+    StringPiece(const char *str)
+        :   ptr_(str), length_(::strlen(str))
+    {}
+    StringPiece(const std::string &str)
+        :   ptr_(str.data()), length_(str.size())
+    {}
+    StringPiece(const char *data, size_t len)
+        :   ptr_(data), length_(len)
+    {}
+
+    const char* data() const    { return ptr_; }
+    size_t size() const { return length_; }
+    bool empty() const  { return length_ == 0; }
+    const char* begin() const   { return ptr_; }
+    const char* end() const { return ptr_ + length_; }
+
+    char operator[](size_t i) const { return ptr_[i]; }
+
+    void removePrefix(size_t n)
+    {
+        ptr_ += n;
+        length_ -= n;
+    }
+
+    void removeSuffix(size_t n)
+    {
+        length_ -= n;
+    }
+
+    std::string toString() const    { return std::string(ptr_, length_); }
+
+    bool operator==(const StringPiece &rhs) const
+    {
+        return length_ == rhs.length_ && ::memcmp(ptr_, rhs.ptr_, length_) == 0;
+    }
+    bool operator!=(const StringPiece &rhs) const   { return !(*this == rhs); }
+
+private:
+    const char *ptr_;
+    size_t length_;
+};
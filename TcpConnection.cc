@@ -3,6 +3,7 @@
 #include "Socket.h"
 #include "Channel.h"
 #include "EventLoop.h"
+#include "IoUringPoller.h"
 
 #include <errno.h>
 #include <unistd.h>
@@ -30,7 +31,11 @@ TcpConnection::TcpConnection(EventLoop *loop,
             channel_(new Channel(loop,sockfd)),
             localAddr_(localAddr),
             peerAddr_(peerAddr),
-            HighWaterMark_(64*1024*1024)
+            HighWaterMark_(64*1024*1024),
+            idleTimeout_(0.0),
+            completionIo_(false),
+            uring_(nullptr),
+            completionPending_(0)
 
 {
     //给channel设置相应的回调函数 Poller监听到channel感兴趣的事件发生后 会通知channel执行相应的回调操作
@@ -42,6 +47,8 @@ TcpConnection::TcpConnection(EventLoop *loop,
         std::bind(&TcpConnection::handleClose, this));
     channel_->setErrorCallback(
         std::bind(&TcpConnection::handleError, this));
+    channel_->setCompletionCallback(
+        std::bind(&TcpConnection::handleCompletion, this, std::placeholders::_1));
     LOG_INFO("TcpConnection::ctor[ %s ] st fd = %d \n", name_.c_str(), sockfd);
     
     //开启Tcp/Ip层的心跳包检测
@@ -54,14 +61,30 @@ TcpConnection::~TcpConnection()
         name_.c_str(), channel_->fd(), (int)state_);
 }
 
+const size_t TcpConnection::kEdgeReadBudget;
+
+void TcpConnection::setEdgeTriggered(bool on)
+{
+    channel_->setEdgeTriggered(on);
+}
+
 //从sockfd中读数据到inputBuffer
 void TcpConnection::handleRead(Timestamp receiveTime)
 {
+    if(channel_->edgeTriggered())
+    {
+        handleReadEdgeTriggered(receiveTime);
+        return;
+    }
     int saveError = 0;
     //将socketfd中的数据从内核的缓冲区读到inpuBuffer的应用层缓冲区;
     ssize_t n = inputBuffer_.readFd(channel_->fd(), &saveError);
     if(n > 0)
     {
+        if(idleEntry_.linked())
+        {
+            idleEntry_.touch();
+        }
         //已经建立连接的用户 有可读事件发生，调用用户传入的 读事件回调
         //TcpConnection的messageCallback_由TcpServer设置，
         //而TcpServer的又由更上一层（用户应用层）设置。其中如何按协议解包在这个函数内实现。
@@ -80,19 +103,84 @@ void TcpConnection::handleRead(Timestamp receiveTime)
         
 }
 
+//边缘触发: 不读到EAGAIN就不会再有通知 所以一直读 读到的数据一次交给messageCallback_
+//超过kEdgeReadBudget还没读完 就把剩下的读放进pendingFunctors 先处理这一轮其他连接的事件
+void TcpConnection::handleReadEdgeTriggered(Timestamp receiveTime)
+{
+    //排队期间连接可能已经关闭
+    if(state_ == kDisconnected)
+    {
+        return;
+    }
+
+    size_t total = 0;
+    int saveError = 0;
+    ssize_t n;
+    while((n = inputBuffer_.readFd(channel_->fd(), &saveError)) > 0)
+    {
+        total += static_cast<size_t>(n);
+        if(total >= kEdgeReadBudget)
+        {
+            break;
+        }
+    }
+
+    if(total > 0)
+    {
+        if(idleEntry_.linked())
+        {
+            idleEntry_.touch();
+        }
+        messageCallback_(shared_from_this(), &inputBuffer_, receiveTime);
+    }
+
+    if(n > 0)   //预算用完 socket里可能还有数据
+    {
+        loop_->queueInLoop(std::bind(&TcpConnection::handleReadEdgeTriggered,
+                                    shared_from_this(), receiveTime));
+    }
+    else if(n == 0)
+    {
+        handleClose();
+    }
+    else if(saveError != EAGAIN && saveError != EWOULDBLOCK)
+    {
+        errno = saveError;
+        LOG_ERROR("Tcpconnection::handleRead");
+        handleError();
+    }
+
+}
+
 //从outputBuffer中写数据到sockfd
 void TcpConnection::handleWrite()
 {
     //如果在关注socketfd内核缓冲区的可写事件的话就执行
     if(channel_->isWriting())
     {
-        //内核缓冲区有空间，可以直接调用write从应用层缓冲区写到内核缓冲区
-        ssize_t n = ::write(channel_->fd(), outputBuffer_.peek(),
-                            outputBuffer_.readableBytes());
+        //内核缓冲区有空间，用一次writev把应用层缓冲区的多个chunk写到内核缓冲区
+        //写入了n个字节就回收应用层的空闲缓冲区空间
+        int saveErrno = 0;
+        ssize_t n = outputBuffer_.writeFd(channel_->fd(), &saveErrno);
+        //边缘触发时没写到EAGAIN就不会再收到可写通知 内核缓冲区还有空间就接着写
+        if(channel_->edgeTriggered())
+        {
+            ssize_t more = n;
+            while(more > 0 && outputBuffer_.readableBytes() > 0)
+            {
+                more = outputBuffer_.writeFd(channel_->fd(), &saveErrno);
+                if(more > 0)
+                {
+                    n += more;
+                }
+            }
+        }
         if(n > 0)
         {
-            //写入了n个字节就回收应用层的空闲缓冲区空间，实际是下标的移动
-            outputBuffer_.retrive(n);
+            if(idleEntry_.linked())
+            {
+                idleEntry_.touch();
+            }
             //说明应用层发送缓冲区已经清空了发送完成
             if(outputBuffer_.readableBytes() == 0) 
             {
@@ -115,8 +203,10 @@ void TcpConnection::handleWrite()
             }
 
         }
-        else
+        //边缘触发下可写通知可能来得比实际可写早(比如io_uring的multishot poll) EAGAIN不算错误
+        else if(saveErrno != EAGAIN && saveErrno != EWOULDBLOCK)
         {
+            errno = saveErrno;
             LOG_ERROR("Tcpconnection::handleWrite");
         }
 
@@ -130,6 +220,90 @@ void TcpConnection::handleWrite()
 
 }
 
+//完成模式: 收到的数据块直接挂到inputBuffer 本轮所有结果处理完再调用一次messageCallback_
+void TcpConnection::handleCompletion(Timestamp receiveTime)
+{
+    bool received = false;
+    bool peerClosed = false;
+    int error = 0;
+    size_t sent = 0;
+    for(IoUringPoller::Completion &c : uring_->takeCompletions(channel_->fd()))
+    {
+        if(c.type == IoUringPoller::Completion::kRecv)
+        {
+            if(c.res > 0)
+            {
+                if(state_ == kDisconnected)
+                {
+                    c.storage->release();
+                }
+                else
+                {
+                    inputBuffer_.appendStorage(c.storage, static_cast<size_t>(c.res));
+                    received = true;
+                }
+            }
+            else if(c.res == 0)
+            {
+                peerClosed = true;
+            }
+            else
+            {
+                error = -c.res;
+            }
+        }
+        else if(c.res > 0)
+        {
+            sent += static_cast<size_t>(c.res);
+        }
+        else
+        {
+            error = -c.res;
+        }
+    }
+
+    if(state_ == kDisconnected)
+    {
+        return;
+    }
+    if((received || sent > 0) && idleEntry_.linked())
+    {
+        idleEntry_.touch();
+    }
+    if(received)
+    {
+        messageCallback_(shared_from_this(), &inputBuffer_, receiveTime);
+    }
+    if(sent > 0)
+    {
+        completionPending_ -= sent;
+        if(completionPending_ == 0)
+        {
+            if(writeCompleteCallback_)
+            {
+                loop_->queueInLoop(std::bind(writeCompleteCallback_, shared_from_this()));
+            }
+            if(state_ == kDisconnecting)
+            {
+                shutdownInLoop();
+            }
+        }
+    }
+
+    //收发出错或对端关闭后poller不再继续recv 连接走关闭流程
+    if(error != 0)
+    {
+        errno = error;
+        LOG_ERROR("Tcpconnection::handleCompletion");
+        handleError();
+        handleClose();
+    }
+    else if(peerClosed)
+    {
+        handleClose();
+    }
+}
+
 
 /*
 TcpConnection生命管理的步骤：
@@ -167,6 +341,17 @@ void TcpConnection::handleClose()
 
 }
 
+//时间轮上的空闲超时回调 走和对端关闭连接相同的handleClose流程
+void TcpConnection::handleIdleTimeout()
+{
+    LOG_INFO("TcpConnection::handleIdleTimeout [ %s ] fd = %d idle timeout \n",
+        name_.c_str(), channel_->fd());
+    if(state_ == kConnected || state_ == kDisconnecting)
+    {
+        handleClose();
+    }
+}
+
 void TcpConnection::handleError()
 {
     int optval;
@@ -196,16 +381,100 @@ void TcpConnection::send(const std::string &buf)
         }
         else
         {
+            //拷贝一份string放进回调 send返回后调用者的buf就可能失效了
             loop_->runInLoop(std::bind(
-                &TcpConnection::sendInLoop, 
+                &TcpConnection::sendStringInLoop, 
                 this, 
-                buf.c_str(), 
-                buf.size()
+                buf
+                ));
+        }
+    }
+}
+
+void TcpConnection::send(std::string &&buf)
+{
+    if(state_ == kConnected)
+    {
+        if(loop_->isInLoopThread())
+        {
+            sendInLoop(buf.c_str(), buf.size());
+        }
+        else
+        {
+            //string移动进回调 不拷贝数据
+            loop_->runInLoop(std::bind(
+                &TcpConnection::sendStringInLoop, 
+                this, 
+                std::move(buf)
+                ));
+        }
+    }
+}
+
+void TcpConnection::sendStringInLoop(const std::string &buf)
+{
+    sendInLoop(buf.c_str(), buf.size());
+}
+
+void TcpConnection::send(Buffer *buf)
+{
+    if(state_ == kConnected)
+    {
+        if(loop_->isInLoopThread())
+        {
+            if(uring_ != nullptr)
+            {
+                //存储整块交给poller发送 不拷贝
+                sendCompletionInLoop(buf->retriveAllAsSlice());
+            }
+            else
+            {
+                sendInLoop(buf->peek(), buf->readableBytes());
+                buf->retriveAll();
+            }
+        }
+        else
+        {
+            //把buf的存储整块交给slice 跨线程也不用拷贝
+            loop_->runInLoop(std::bind(
+                &TcpConnection::sendSliceInLoop,
+                this,
+                buf->retriveAllAsSlice()
                 ));
         }
     }
 }
 
+void TcpConnection::sendSliceInLoop(const BufferSlice &slice)
+{
+    if(uring_ != nullptr)
+    {
+        sendCompletionInLoop(slice);
+        return;
+    }
+    sendInLoop(slice.data(), slice.size());
+}
+
+//完成模式下数据由slice持有 排进poller的发送队列 完成后在handleCompletion里计数
+void TcpConnection::sendCompletionInLoop(BufferSlice slice)
+{
+    if(state_ == kDisconnected)
+    {
+        LOG_ERROR("disconnected, give up writing!");
+        return;
+    }
+    const size_t len = slice.size();
+    if(completionPending_ + len >= HighWaterMark_
+        && completionPending_ < HighWaterMark_
+        && highWaterMarkCallback_)
+    {
+        loop_->queueInLoop(std::bind(highWaterMarkCallback_,
+                    shared_from_this(), completionPending_ + len));
+    }
+    completionPending_ += len;
+    uring_->send(channel_.get(), std::move(slice));
+}
+
 /*
 发送数据 上层应用写得快 内核发送数据慢  需要把待发送的数据写入缓冲区 且设置了高水位回调
 */
@@ -222,6 +491,12 @@ void TcpConnection::sendInLoop(const void* data, size_t len)
         return;
     }
 
+    if(uring_ != nullptr)
+    {
+        sendCompletionInLoop(BufferSlice(static_cast<const char*>(data), len));
+        return;
+    }
+
     /*
     //如果通道（即这个文件描述符）没有关注写事件
     //并且发送缓冲区没有数据。那么可以尝试直接write()
@@ -291,7 +566,21 @@ void TcpConnection::connectEstablished()
 {
     setState(kConnected);
     channel_->tie(shared_from_this());
-    channel_->enableReading();//向poller上注册channel的epollin事件
+    if(completionIo_ && loop_->completionIo() != nullptr)
+    {
+        uring_ = loop_->completionIo();
+        uring_->startCompletionIo(channel_.get());
+    }
+    else
+    {
+        channel_->enableReading();//向poller上注册channel的epollin事件
+    }
+
+    if(idleTimeout_ > 0.0)
+    {
+        loop_->timingWheel()->add(&idleEntry_, idleTimeout_,
+            std::bind(&TcpConnection::handleIdleTimeout, this));
+    }
 
     //新连接建立 执行回调
     connectionCallback_(shared_from_this());
@@ -308,6 +597,11 @@ void TcpConnection::connectDestoryed()
     }
     channel_->remove();//把channel从poller中删除掉
 
+    if(idleEntry_.linked())
+    {
+        loop_->timingWheel()->remove(&idleEntry_);
+    }
+
 }
 
 //关闭连接
@@ -323,7 +617,8 @@ void TcpConnection::shutdown()
 
 void TcpConnection::shutdownInLoop()
 {
-    if(!channel_->isWriting())  //说明当前output中数据发送完成
+    //说明当前output中数据发送完成 完成模式下还要等poller里的数据发完
+    if(!channel_->isWriting() && completionPending_ == 0)
     {
         socket_->shutdownWrite(); //socket关闭写端 poller会通知该事件
     }
@@ -3,7 +3,9 @@
 #include "InetAddress.h"
 #include "Callbacks.h"
 #include "Buffer.h"
+#include "ChainBuffer.h"
 #include "Timestamp.h"
+#include "TimingWheel.h"
 
 #include <memory>
 #include <atomic>
@@ -12,6 +14,7 @@
 class Channel;
 class EventLoop;
 class Socket;
+class IoUringPoller;
 
 /*
 TcpServer => Acceptor => 有一个新用户连接 通过accept函数拿到connfd
@@ -39,6 +42,10 @@ public:
 
     //发送数据
     void send(const std::string &buf);
+    //其他线程调用时string直接移动到loop线程 不拷贝
+    void send(std::string &&buf);
+    //发送buf中全部可读数据并取走 不经过std::string拷贝
+    void send(Buffer *buf);
 
     //关闭连接
     void shutdown();
@@ -60,6 +67,19 @@ public:
     void setCloseCallback(const CloseCallback &cb)
     { closeCallback_ = cb; }
 
+    //空闲超时时间 超过seconds秒没有读写就关闭连接  需要在connectEstablished之前设置
+    void setIdleTimeout(double seconds) { idleTimeout_ = seconds; }
+
+    //输入缓冲区改用magic ring 失败时保持普通缓冲区  需要在connectEstablished之前设置
+    void setInputRingSize(size_t bytes) { inputBuffer_.enableRing(bytes); }
+
+    //socket改用边缘触发  读写都做到EAGAIN为止  需要在connectEstablished之前设置
+    void setEdgeTriggered(bool on);
+
+    //loop的poller是IoUringPoller且内核支持时 改用完成模式收发: 内核直接收进缓冲块 发送不经过outputBuffer
+    //不支持时仍按就绪通知读写  需要在connectEstablished之前设置
+    void setCompletionIo(bool on) { completionIo_ = on; }
+
     //建立连接
     void connectEstablished();
     //销毁连接
@@ -68,13 +88,21 @@ public:
 
 private:
     enum statE { kDisconnected, kConnecting, kConnected, kDisconnecting};
+    //边缘触发时一次读事件最多读这么多字节 剩下的排到本轮循环的最后再读 不让一个连接占满loop
+    static const size_t kEdgeReadBudget = 1024 * 1024;
     void setState(statE state) { state_ = state; }
     void handleRead(Timestamp receiveTime);
+    void handleReadEdgeTriggered(Timestamp receiveTime);
     void handleWrite();
+    void handleCompletion(Timestamp receiveTime);
     void handleClose();
     void handleError();
+    void handleIdleTimeout();
 
     void sendInLoop(const void* data, size_t len);
+    void sendStringInLoop(const std::string &buf);
+    void sendSliceInLoop(const BufferSlice &slice);
+    void sendCompletionInLoop(BufferSlice slice);
     void shutdownInLoop();
     
     
@@ -109,10 +137,22 @@ private:
     //用户缓冲区的大小到达一定大小时会做额外的处理：关闭连接。这个是上限值
     size_t HighWaterMark_;
 
+    //空闲超时  <= 0 表示不检测
+    double idleTimeout_;
+    //挂在loop的时间轮上 读写时touch
+    TimingWheel::Entry idleEntry_;
+
     //从socketfd的读取数据放入的应用层缓冲区
     Buffer inputBuffer_;
     //将应用层缓冲区数据写入到socketfd发送的应用层缓冲区
-    Buffer outputBuffer_;
+    //分段缓冲区 大量数据追加时不会扩容拷贝 handleWrite用writev发送
+    ChainBuffer outputBuffer_;
+
+    bool completionIo_;
+    //完成模式生效时指向loop的poller
+    IoUringPoller *uring_;
+    //交给poller还没有发送完成的字节 相当于完成模式下的outputBuffer
+    size_t completionPending_;
 
 };
 
@@ -2,6 +2,7 @@
 #include "Logger.h"
 #include "TcpConnection.h"
 #include <strings.h>
+#include <future>
 
 EventLoop* CheckLoopNotNull(EventLoop* loop)
 {
@@ -13,6 +14,22 @@ EventLoop* CheckLoopNotNull(EventLoop* loop)
     return loop;
 }
 
+//在loop的线程中执行cb 等它执行完再返回
+static void runInLoopAndWait(EventLoop *loop, const std::function<void()> &cb)
+{
+    if(loop->isInLoopThread())
+    {
+        cb();
+        return;
+    }
+    std::promise<void> done;
+    loop->runInLoop([&cb, &done] {
+        cb();
+        done.set_value();
+    });
+    done.get_future().wait();
+}
+
 TcpServer::TcpServer(EventLoop *loop,
             const InetAddress &listenAddr,
             const std::string &name,
@@ -20,16 +37,28 @@ TcpServer::TcpServer(EventLoop *loop,
             : loop_(CheckLoopNotNull(loop)),
               ipPort_(listenAddr.toIpPort()),
               name_(name),
-              acceptor_(new Acceptor(loop, listenAddr, option == kReusePort)),
+              listenAddr_(listenAddr),
+              acceptor_(option == kReusePortPerLoop ? nullptr
+                        : new Acceptor(loop, listenAddr, option == kReusePort)),
               threadPool_(new EventLoopThreadPool(loop, name)),
               connectionCallback_(),
               messageCallback_(),
+              started_(0),
               nextConnId_(1),
-              started_(0)
+              idleTimeout_(0.0),
+              inputRingSize_(0),
+              edgeTriggered_(false),
+              completionIo_(false),
+              cpuSteering_(false),
+              deferAcceptSeconds_(0),
+              alive_(std::make_shared<int>(0))
 
 {
-    acceptor_->setNewConnectionCallback(std::bind(&TcpServer::newConnection, this, 
-            std::placeholders::_1, std::placeholders::_2));
+    if(acceptor_)
+    {
+        acceptor_->setNewConnectionCallback(std::bind(&TcpServer::newConnection, this, 
+                std::placeholders::_1, std::placeholders::_2));
+    }
 }
 
 
@@ -46,6 +75,23 @@ TcpServer::~TcpServer()
             );
     }
 
+    //Acceptor和连接表属于各自的loop 在那个loop中销毁
+    for(std::unique_ptr<LoopAcceptor> &item : loopAcceptors_)
+    {
+        LoopAcceptor *shard = item.get();
+        runInLoopAndWait(shard->loop, [shard] {
+            shard->acceptor.reset();
+            shard->alive.reset();
+            for(auto &entry : shard->connections)
+            {
+                TcpConnectionPtr conn(entry.second);
+                entry.second.reset();
+                conn->connectDestoryed();
+            }
+            shard->connections.clear();
+        });
+    }
+
 }
 
 //设置底层subloop的个数
@@ -60,7 +106,47 @@ void TcpServer::start()
     if(started_++ == 0 ) //防止一个TcpServer被start多次
     {
         threadPool_->start(threadInitCallback_);//启动底层loop线程池
-        loop_->runInLoop(std::bind(&Acceptor::listen, acceptor_.get()));
+        if(acceptor_)
+        {
+            if(deferAcceptSeconds_ > 0)
+            {
+                acceptor_->setDeferAccept(deferAcceptSeconds_);
+            }
+            loop_->runInLoop(std::bind(&Acceptor::listen, acceptor_.get()));
+        }
+        else
+        {
+            startLoopAcceptors();
+        }
+    }
+}
+
+//每个loop一个Acceptor 依次在各自的loop中listen
+//listen的顺序就是socket在SO_REUSEPORT组中的序号 CBPF程序按这个序号选择socket
+void TcpServer::startLoopAcceptors()
+{
+    std::vector<EventLoop*> loops = threadPool_->getAllLoops();
+    for(size_t i = 0; i < loops.size(); ++i)
+    {
+        std::unique_ptr<LoopAcceptor> shard(new LoopAcceptor);
+        shard->loop = loops[i];
+        shard->index = static_cast<int>(i);
+        shard->nextConnId = 1;
+        shard->alive = std::make_shared<int>(0);
+        shard->acceptor.reset(new Acceptor(loops[i], listenAddr_, true));
+        shard->acceptor->setNewConnectionCallback(std::bind(&TcpServer::newLoopConnection, this,
+                shard.get(), std::placeholders::_1, std::placeholders::_2));
+        if(deferAcceptSeconds_ > 0)
+        {
+            shard->acceptor->setDeferAccept(deferAcceptSeconds_);
+        }
+        Acceptor *acceptor = shard->acceptor.get();
+        runInLoopAndWait(loops[i], [acceptor] { acceptor->listen(); });
+        loopAcceptors_.push_back(std::move(shard));
+    }
+    if(cpuSteering_ && loopAcceptors_.size() > 1)
+    {
+        loopAcceptors_[0]->acceptor->attachReusePortCpuSteering(static_cast<int>(loopAcceptors_.size()));
     }
 }
 
@@ -75,6 +161,35 @@ void TcpServer::newConnection(int sockfd, const InetAddress &peerAddr)
     ++nextConnId_;
     std::string connName = name_ + buf;
 
+    TcpConnectionPtr conn(createConnection(ioLoop, connName, sockfd, peerAddr));
+    connections_[connName] = conn;
+
+    //设置如何关闭连接的回调 conn->shutdown
+    conn->setCloseCallback(std::bind(&TcpServer::removeConnection,
+        loop_, std::weak_ptr<void>(alive_), this, std::placeholders::_1));
+    
+    //直接调用TcpConnection::connectEstablished()方法
+    ioLoop->runInLoop(std::bind(&TcpConnection::connectEstablished, conn));
+}
+
+//kReusePortPerLoop: 在accept它的loop中执行 连接直接在这个loop里建立 不需要唤醒其他线程
+void TcpServer::newLoopConnection(LoopAcceptor *shard, int sockfd, const InetAddress &peerAddr)
+{
+    char buf[64] = {0};
+    snprintf(buf, sizeof buf, " -%s#%d-%d ", ipPort_.c_str(), shard->index, shard->nextConnId);
+    ++shard->nextConnId;
+    std::string connName = name_ + buf;
+
+    TcpConnectionPtr conn(createConnection(shard->loop, connName, sockfd, peerAddr));
+    shard->connections[connName] = conn;
+    conn->setCloseCallback(std::bind(&TcpServer::removeLoopConnection,
+        std::weak_ptr<void>(shard->alive), shard, std::placeholders::_1));
+    conn->connectEstablished();
+}
+
+TcpConnectionPtr TcpServer::createConnection(EventLoop *ioLoop, const std::string &connName,
+                                            int sockfd, const InetAddress &peerAddr)
+{
     LOG_INFO("TcpServer::newConnection [%s] - new connection [%s] from %s \n",
         name_.c_str(), connName.c_str(), peerAddr.toIpPort().c_str());
 
@@ -96,26 +211,32 @@ void TcpServer::newConnection(int sockfd, const InetAddress &peerAddr)
                                 sockfd,
                                 localAddr,
                                 peerAddr));
-    connections_[connName] = conn;
 
 //下面的回调都是用户设置给TcpServer => TcpConnection => Channel => Poller => notify channel调用
     conn->setConnectionCallback(connectionCallback_);
     conn->setMessageCallback(messageCallback_);
     conn->setWriteCompleteCallback(writeCompleteCallback_);
-
-    //设置如何关闭连接的回调 conn->shutdown
-    conn->setCloseCallback(std::bind(
-        &TcpServer::removeConnection, this, std::placeholders::_1));
-    
-    //直接调用TcpConnection::connectEstablished()方法
-    ioLoop->runInLoop(std::bind(&TcpConnection::connectEstablished, conn));
+    conn->setIdleTimeout(idleTimeout_);
+    if(inputRingSize_ > 0)
+    {
+        conn->setInputRingSize(inputRingSize_);
+    }
+    conn->setEdgeTriggered(edgeTriggered_);
+    conn->setCompletionIo(completionIo_);
+    return conn;
 }
 
-void TcpServer::removeConnection(const TcpConnectionPtr &conn)
+//TcpServer在baseloop线程中析构 回到baseloop后检查alive和析构不会交错
+void TcpServer::removeConnection(EventLoop *loop, const std::weak_ptr<void> &alive,
+                                TcpServer *server, const TcpConnectionPtr &conn)
 {
-    loop_->runInLoop(
-        std::bind(&TcpServer::removeConnectionInLoop, this, conn)
-    );
+    loop->runInLoop([alive, server, conn] {
+        //已经析构的TcpServer把连接交给了subloop销毁 这里不用再处理
+        if(!alive.expired())
+        {
+            server->removeConnectionInLoop(conn);
+        }
+    });
 }
 
 
@@ -129,4 +250,21 @@ void TcpServer::removeConnectionInLoop(const TcpConnectionPtr &conn)
     ioLoop->queueInLoop(
         std::bind(&TcpConnection::connectDestoryed, conn)
     );
+}
+
+//kReusePortPerLoop: 连接表就在连接所属的loop中 不用回到baseloop
+void TcpServer::removeLoopConnection(const std::weak_ptr<void> &alive, LoopAcceptor *shard,
+                                    const TcpConnectionPtr &conn)
+{
+    //TcpServer析构时已经在这个loop中销毁了连接 shard也可能已经释放
+    if(alive.expired())
+    {
+        return;
+    }
+    LOG_INFO("TcpServer::removeLoopConnection - connection %s \n", conn->name().c_str());
+
+    shard->connections.erase(conn->name());
+    shard->loop->queueInLoop(
+        std::bind(&TcpConnection::connectDestoryed, conn)
+    );
 }
\ No newline at end of file
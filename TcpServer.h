@@ -24,6 +24,8 @@ public:
     {
         kNoReusePort,
         kReusePort,
+        //每个loop线程一个SO_REUSEPORT的监听socket和Acceptor  连接在accept它的loop中处理 不再由baseloop分发
+        kReusePortPerLoop,
     };
 
     TcpServer(EventLoop *loop,
@@ -42,6 +44,26 @@ public:
     { writeCompleteCallback_ = cb; }
 
 
+    //空闲连接超时 超过seconds秒没有读写的连接会被关闭  需要在start之前设置
+    void setIdleTimeout(double seconds) { idleTimeout_ = seconds; }
+
+    //连接的输入缓冲区使用bytes大小的magic ring(见Buffer)  0表示普通缓冲区  需要在start之前设置
+    void setInputRingSize(size_t bytes) { inputRingSize_ = bytes; }
+
+    //连接的socket使用边缘触发(EPOLLET) 默认水平触发  需要在start之前设置
+    void setEdgeTriggered(bool on) { edgeTriggered_ = on; }
+
+    //subloop使用IoUringPoller(MUDUO_USE_URING)时 连接用完成模式收发 内核不支持时忽略  需要在start之前设置
+    void setCompletionIo(bool on) { completionIo_ = on; }
+
+    //kReusePortPerLoop时按收到SYN的CPU选择监听socket(第CPU % loop数个)  loop线程需要由ThreadInitCallback绑到对应的CPU上
+    //需要在start之前设置
+    void setReusePortCpuSteering(bool on) { cpuSteering_ = on; }
+
+    //监听socket打开TCP_DEFER_ACCEPT 连接上有数据(或超过seconds秒)才accept  只适合客户端先发数据的协议
+    //0表示关闭  需要在start之前设置
+    void setDeferAccept(int seconds) { deferAcceptSeconds_ = seconds; }
+
     //设置底层subloop的个数
     void setThreadNum(int numThreads);
     
@@ -50,17 +72,41 @@ public:
 
 private:
     void newConnection(int sockfd, const InetAddress &peerAddr);
-    void removeConnection(const TcpConnectionPtr &conn);
+    //在连接所属的subloop中调用 这时TcpServer可能正在baseloop中析构 不能访问成员
+    //回到baseloop后 alive没有失效才交给removeConnectionInLoop
+    static void removeConnection(EventLoop *loop, const std::weak_ptr<void> &alive,
+                                TcpServer *server, const TcpConnectionPtr &conn);
     void removeConnectionInLoop(const TcpConnectionPtr &conn);
+    //创建连接对象并设置除closeCallback以外的回调
+    TcpConnectionPtr createConnection(EventLoop *ioLoop, const std::string &connName,
+                                    int sockfd, const InetAddress &peerAddr);
 
     using ConnectionMap = std::unordered_map<std::string, TcpConnectionPtr>;
 
+    //kReusePortPerLoop: 每个loop自己的Acceptor和连接表 只在这个loop的线程中访问
+    struct LoopAcceptor
+    {
+        EventLoop *loop;
+        int index;
+        int nextConnId;
+        std::unique_ptr<Acceptor> acceptor;
+        ConnectionMap connections;
+        //在这个loop中销毁连接表时reset 和closeCallback在同一个线程 检查不会和析构交错
+        std::shared_ptr<void> alive;
+    };
+    void startLoopAcceptors();
+    void newLoopConnection(LoopAcceptor *shard, int sockfd, const InetAddress &peerAddr);
+    //在连接所属的loop中调用 alive失效说明TcpServer已经销毁了这个连接表
+    static void removeLoopConnection(const std::weak_ptr<void> &alive, LoopAcceptor *shard,
+                                    const TcpConnectionPtr &conn);
+
     EventLoop *loop_;//baseloop 用户定义的loop  
 
     const std::string ipPort_;
     const std::string name_;
+    const InetAddress listenAddr_;
 
-    std::unique_ptr<Acceptor> acceptor_;//运行在mainloop  监听新连接事件
+    std::unique_ptr<Acceptor> acceptor_;//运行在mainloop  监听新连接事件  kReusePortPerLoop时为空
 
     std::shared_ptr<EventLoopThreadPool> threadPool_;//one loop pre thread
 
@@ -73,7 +119,16 @@ private:
     std::atomic_int started_;
 
     int nextConnId_;
+    double idleTimeout_;
+    size_t inputRingSize_;
+    bool edgeTriggered_;
+    bool completionIo_;
+    bool cpuSteering_;
+    int deferAcceptSeconds_;
     ConnectionMap connections_;
+    std::vector<std::unique_ptr<LoopAcceptor>> loopAcceptors_;
+    //随TcpServer析构 让还在路上的removeConnection知道TcpServer已经不在了
+    std::shared_ptr<void> alive_;
 
 
 };
\ No newline at end of file
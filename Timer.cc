@@ -0,0 +1,15 @@
+#include "Timer.h"
+
+std::atomic<int64_t> Timer::s_numCreated_(0);
+
+void Timer::restart(int64_t now)
+{
+    if(repeat_)
+    {
+        expiration_ = now + static_cast<int64_t>(interval_ * Timestamp::kMicroSecondsPerSecond);
+    }
+    else
+    {
+        expiration_ = 0;
+    }
+}
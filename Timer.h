@@ -0,0 +1,53 @@
+#pragma once
+
+#include "noncopyable.h"
+#include "Timestamp.h"
+#include "Callbacks.h"
+
+#include <atomic>
+
+//定时器  记录超时时间 超时回调 以及是否重复触发
+//超时时间使用单调时钟的微秒数 系统时间被调整时定时器不会提前或者推迟触发
+//heapIndex_ 记录定时器在TimerQueue最小堆中的下标 删除时不需要查找 O(log n)
+class Timer : noncopyable
+{
+public:
+    Timer(TimerCallback cb, int64_t expiration, double interval)
+        :   callback_(std::move(cb)),
+            expiration_(expiration),
+            interval_(interval),
+            repeat_(interval > 0.0),
+            canceled_(false),
+            sequence_(++s_numCreated_),
+            heapIndex_(-1)
+    {}
+
+    void run() const { callback_(); }
+
+    int64_t expiration() const { return expiration_; }
+    bool repeat() const { return repeat_; }
+    int64_t sequence() const { return sequence_; }
+
+    //重复定时器到期后 以now为起点计算下一次超时时间
+    void restart(int64_t now);
+
+    //在超时回调中被cancel的重复定时器 不再重新加入堆中
+    bool canceled() const { return canceled_; }
+    void cancel() { canceled_ = true; }
+
+    int heapIndex() const { return heapIndex_; }
+    void setHeapIndex(int index) { heapIndex_ = index; }
+
+    static int64_t numCreated() { return s_numCreated_; }
+
+private:
+    const TimerCallback callback_;
+    int64_t expiration_;
+    const double interval_;
+    const bool repeat_;
+    bool canceled_;
+    const int64_t sequence_;
+    int heapIndex_;
+
+    static std::atomic<int64_t> s_numCreated_;
+};
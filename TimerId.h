@@ -0,0 +1,27 @@
+#pragma once
+
+#include <stdint.h>
+
+class Timer;
+
+//用户持有的定时器标识 用于EventLoop::cancel
+//sequence_用来区分地址被复用的不同Timer对象
+class TimerId
+{
+public:
+    TimerId()
+        :   timer_(nullptr),
+            sequence_(0)
+    {}
+
+    TimerId(Timer *timer, int64_t seq)
+        :   timer_(timer),
+            sequence_(seq)
+    {}
+
+    friend class TimerQueue;
+
+private:
+    Timer *timer_;
+    int64_t sequence_;
+};
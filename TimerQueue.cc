@@ -0,0 +1,234 @@
+#include "TimerQueue.h"
+#include "Timer.h"
+#include "TimerId.h"
+#include "EventLoop.h"
+#include "Logger.h"
+
+#include <sys/timerfd.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+
+static int createTimerfd()
+{
+    int timerfd = ::timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if(timerfd < 0)
+    {
+        LOG_FATAL("timerfd_create error : %d \n", errno);
+    }
+    return timerfd;
+}
+
+TimerQueue::TimerQueue(EventLoop *loop)
+    :   loop_(loop),
+        timerfd_(createTimerfd()),
+        timerfdChannel_(loop, timerfd_),
+        callingExpiredTimers_(false)
+{
+    timerfdChannel_.setReadCallback(std::bind(&TimerQueue::handleRead, this));
+    timerfdChannel_.enableReading();
+}
+
+TimerQueue::~TimerQueue()
+{
+    timerfdChannel_.disableAll();
+    timerfdChannel_.remove();
+    ::close(timerfd_);
+    for(const Entry &entry : heap_)
+    {
+        delete entry.timer;
+    }
+}
+
+TimerId TimerQueue::addTimer(TimerCallback cb, int64_t expiration, double interval)
+{
+    Timer *timer = new Timer(std::move(cb), expiration, interval);
+    loop_->runInLoop(std::bind(&TimerQueue::addTimerInLoop, this, timer));
+    return TimerId(timer, timer->sequence());
+}
+
+void TimerQueue::cancel(TimerId timerId)
+{
+    loop_->runInLoop(std::bind(&TimerQueue::cancelInLoop, this, timerId));
+}
+
+void TimerQueue::addTimerInLoop(Timer *timer)
+{
+    timers_[timer->sequence()] = timer;
+    if(insert(timer))
+    {
+        resetTimerfd(timer->expiration());
+    }
+}
+
+void TimerQueue::cancelInLoop(TimerId timerId)
+{
+    auto it = timers_.find(timerId.sequence_);
+    if(it == timers_.end() || it->second != timerId.timer_)
+    {
+        return; //已经到期或者已经被取消
+    }
+
+    Timer *timer = it->second;
+    if(timer->heapIndex() >= 0)
+    {
+        removeAt(static_cast<size_t>(timer->heapIndex()));
+        timers_.erase(it);
+        delete timer;
+    }
+    else if(callingExpiredTimers_)
+    {
+        //定时器正在expired_中执行回调(比如在自己的回调里cancel自己) 由handleRead负责释放
+        timer->cancel();
+    }
+    //堆顶被删除时不必重设timerfd  多触发的一次handleRead没有到期的定时器
+}
+
+void TimerQueue::handleRead()
+{
+    uint64_t howmany;
+    ssize_t n = ::read(timerfd_, &howmany, sizeof howmany);
+    if(n != sizeof howmany)
+    {
+        LOG_ERROR("TimerQueue::handleRead() reads %ld bytes instead of 8 \n", n);
+    }
+
+    int64_t now = Timestamp::monotonicMicroseconds();
+    //把所有到期的定时器从堆中取出
+    expired_.clear();
+    while(!heap_.empty() && heap_[0].expiration <= now)
+    {
+        expired_.push_back(heap_[0].timer);
+        removeAt(0);
+    }
+
+    callingExpiredTimers_ = true;
+    for(Timer *timer : expired_)
+    {
+        timer->run();
+    }
+    callingExpiredTimers_ = false;
+
+    //重复的定时器重新加入堆中 其余的释放掉
+    for(Timer *timer : expired_)
+    {
+        if(timer->repeat() && !timer->canceled())
+        {
+            timer->restart(now);
+            insert(timer);
+        }
+        else
+        {
+            timers_.erase(timer->sequence());
+            delete timer;
+        }
+    }
+    expired_.clear();
+
+    if(!heap_.empty())
+    {
+        resetTimerfd(heap_[0].expiration);
+    }
+}
+
+bool TimerQueue::insert(Timer *timer)
+{
+    Entry entry = { timer->expiration(), timer };
+    heap_.push_back(entry);
+    timer->setHeapIndex(static_cast<int>(heap_.size() - 1));
+    siftUp(heap_.size() - 1);
+    return heap_[0].timer == timer;
+}
+
+void TimerQueue::removeAt(size_t index)
+{
+    heap_[index].timer->setHeapIndex(-1);
+    size_t last = heap_.size() - 1;
+    if(index != last)
+    {
+        //用最后一个节点填补空位 再根据大小决定上浮还是下沉
+        place(index, heap_[last]);
+        heap_.pop_back();
+        if(index > 0 && heap_[index].expiration < heap_[(index - 1) / kArity].expiration)
+        {
+            siftUp(index);
+        }
+        else
+        {
+            siftDown(index);
+        }
+    }
+    else
+    {
+        heap_.pop_back();
+    }
+}
+
+void TimerQueue::siftUp(size_t index)
+{
+    Entry entry = heap_[index];
+    while(index > 0)
+    {
+        size_t parent = (index - 1) / kArity;
+        if(!(entry.expiration < heap_[parent].expiration))
+        {
+            break;
+        }
+        place(index, heap_[parent]);
+        index = parent;
+    }
+    place(index, entry);
+}
+
+void TimerQueue::siftDown(size_t index)
+{
+    const size_t size = heap_.size();
+    Entry entry = heap_[index];
+    while(true)
+    {
+        size_t first = index * kArity + 1;
+        if(first >= size)
+        {
+            break;
+        }
+        size_t last = first + kArity < size ? first + kArity : size;
+        size_t minChild = first;
+        for(size_t child = first + 1; child < last; ++child)
+        {
+            if(heap_[child].expiration < heap_[minChild].expiration)
+            {
+                minChild = child;
+            }
+        }
+        if(!(heap_[minChild].expiration < entry.expiration))
+        {
+            break;
+        }
+        place(index, heap_[minChild]);
+        index = minChild;
+    }
+    place(index, entry);
+}
+
+void TimerQueue::place(size_t index, const Entry &entry)
+{
+    heap_[index] = entry;
+    entry.timer->setHeapIndex(static_cast<int>(index));
+}
+
+//超时时间和timerfd使用同一个单调时钟 直接设置绝对时间
+void TimerQueue::resetTimerfd(int64_t expiration)
+{
+    struct itimerspec newValue;
+    bzero(&newValue, sizeof newValue);
+    if(expiration <= 0)
+    {
+        expiration = 1; //it_value全为0会停止timerfd
+    }
+    newValue.it_value.tv_sec = static_cast<time_t>(expiration / Timestamp::kMicroSecondsPerSecond);
+    newValue.it_value.tv_nsec = static_cast<long>((expiration % Timestamp::kMicroSecondsPerSecond) * 1000);
+    if(::timerfd_settime(timerfd_, TFD_TIMER_ABSTIME, &newValue, NULL) < 0)
+    {
+        LOG_ERROR("timerfd_settime error : %d \n", errno);
+    }
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "noncopyable.h"
+#include "Timestamp.h"
+#include "Callbacks.h"
+#include "Channel.h"
+
+#include <vector>
+#include <unordered_map>
+
+class EventLoop;
+class Timer;
+class TimerId;
+
+/*
+每个EventLoop拥有一个TimerQueue  通过timerfd把定时器事件和IO事件统一到poller中处理
+定时器按超时时间组织成一个4叉最小堆:
+    节点中直接保存超时时间 比较时不需要解引用Timer 4个孩子正好落在一个cache line内
+    Timer记录自己在堆中的下标 addTimer / cancel 都是 O(log n)
+*/
+class TimerQueue : noncopyable
+{
+public:
+    explicit TimerQueue(EventLoop *loop);
+    ~TimerQueue();
+
+    //线程安全 可以在其他线程中调用  expiration为单调时钟的微秒数
+    TimerId addTimer(TimerCallback cb, int64_t expiration, double interval);
+    void cancel(TimerId timerId);
+
+    //当前堆中定时器的个数 只能在loop线程中调用
+    size_t size() const { return heap_.size(); }
+
+private:
+    struct Entry
+    {
+        int64_t expiration; //单调时钟 微秒
+        Timer *timer;
+    };
+    using EntryList = std::vector<Entry>;
+    //sequence => Timer  cancel时用来判断TimerId指向的定时器是否还存活
+    using TimerMap = std::unordered_map<int64_t, Timer*>;
+
+    static const size_t kArity = 4;
+
+    void addTimerInLoop(Timer *timer);
+    void cancelInLoop(TimerId timerId);
+    //timerfd的读事件回调
+    void handleRead();
+
+    //插入堆  返回插入后是否成为最早到期的定时器
+    bool insert(Timer *timer);
+    void removeAt(size_t index);
+    void siftUp(size_t index);
+    void siftDown(size_t index);
+    void place(size_t index, const Entry &entry);
+
+    //重新设置timerfd的超时时间为堆顶定时器的超时时间
+    void resetTimerfd(int64_t expiration);
+
+    EventLoop *loop_;
+    const int timerfd_;
+    Channel timerfdChannel_;
+
+    EntryList heap_;
+    TimerMap timers_;
+
+    //本次已到期的定时器
+    std::vector<Timer*> expired_;
+    bool callingExpiredTimers_;
+};
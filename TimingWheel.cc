@@ -0,0 +1,125 @@
+#include "TimingWheel.h"
+#include "EventLoop.h"
+
+#include <math.h>
+
+TimingWheel::Entry::~Entry()
+{
+    if(linked())
+    {
+        wheel_->remove(this);
+    }
+}
+
+TimingWheel::TimingWheel(EventLoop *loop, double tickSeconds, size_t numSlots)
+    :   loop_(loop),
+        tickSeconds_(tickSeconds),
+        slots_(numSlots),
+        currentTick_(0),
+        size_(0)
+{
+    for(Entry &head : slots_)
+    {
+        head.prev_ = &head;
+        head.next_ = &head;
+    }
+    tickTimer_ = loop_->runEvery(tickSeconds_, std::bind(&TimingWheel::onTick, this));
+}
+
+TimingWheel::~TimingWheel()
+{
+    loop_->cancel(tickTimer_);
+    for(Entry &head : slots_)
+    {
+        while(head.next_ != &head)
+        {
+            Entry *entry = head.next_;
+            unlink(entry);
+            entry->wheel_ = nullptr;
+        }
+    }
+}
+
+void TimingWheel::add(Entry *entry, double timeoutSeconds, ExpireCallback cb)
+{
+    if(entry->linked())
+    {
+        remove(entry);
+    }
+    int64_t ticks = static_cast<int64_t>(::ceil(timeoutSeconds / tickSeconds_));
+    entry->timeoutTicks_ = ticks > 0 ? ticks : 1;
+    entry->lastTouched_ = currentTick_;
+    entry->callback_ = std::move(cb);
+    entry->wheel_ = this;
+    link(entry, expireTick(entry));
+    ++size_;
+}
+
+void TimingWheel::remove(Entry *entry)
+{
+    unlink(entry);
+    entry->wheel_ = nullptr;
+    --size_;
+}
+
+//转动一格 批量处理当前槽中的Entry
+void TimingWheel::onTick()
+{
+    ++currentTick_;
+    Entry &head = slots_[currentTick_ % slots_.size()];
+    if(head.next_ == &head)
+    {
+        return;
+    }
+
+    //先把整个槽摘下来 挂到局部的哨兵上 回调中remove其他Entry也是安全的
+    Entry pending;
+    pending.next_ = head.next_;
+    pending.prev_ = head.prev_;
+    pending.next_->prev_ = &pending;
+    pending.prev_->next_ = &pending;
+    head.next_ = &head;
+    head.prev_ = &head;
+
+    while(pending.next_ != &pending)
+    {
+        Entry *entry = pending.next_;
+        unlink(entry);
+        int64_t deadline = expireTick(entry);
+        if(deadline > currentTick_)
+        {
+            //期间有touch 挂到新的超时槽
+            link(entry, deadline);
+        }
+        else
+        {
+            entry->wheel_ = nullptr;
+            --size_;
+            ExpireCallback cb(std::move(entry->callback_));
+            cb();   //回调中可能会释放entry所在的对象 之后不能再访问entry
+        }
+    }
+}
+
+//touch可能发生在tick中间的任何时刻 要多等一个tick才能保证至少过了timeoutTicks个tick
+int64_t TimingWheel::expireTick(const Entry *entry)
+{
+    return entry->lastTouched_ + entry->timeoutTicks_ + 1;
+}
+
+void TimingWheel::link(Entry *entry, int64_t deadline)
+{
+    Entry &head = slots_[deadline % slots_.size()];
+    entry->prev_ = head.prev_;
+    entry->next_ = &head;
+    head.prev_->next_ = entry;
+    head.prev_ = entry;
+}
+
+void TimingWheel::unlink(Entry *entry)
+{
+    entry->prev_->next_ = entry->next_;
+    entry->next_->prev_ = entry->prev_;
+    entry->prev_ = nullptr;
+    entry->next_ = nullptr;
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "noncopyable.h"
+#include "TimerId.h"
+
+#include <functional>
+#include <vector>
+#include <stdint.h>
+#include <stddef.h>
+
+class EventLoop;
+
+/*
+哈希时间轮  用来管理大量连接的空闲超时
+    每个槽是一个侵入式双向链表  Entry内嵌在被管理的对象里(比如TcpConnection) 不需要额外分配内存
+    touch()只记录最后一次活跃的tick  O(1) 不移动链表节点
+    槽到期时批量处理: 仍然活跃的Entry按照 lastTouched + timeout 重新挂到对应的槽 其余的执行超时回调
+    超时时间超过一圈的Entry 每转一圈检查一次
+超时精度为一个tick  回调在最后一次touch之后的 [timeout, timeout + tick] 之间触发
+只能在所属loop的线程中使用
+*/
+class TimingWheel : noncopyable
+{
+public:
+    using ExpireCallback = std::function<void()>;
+
+    class Entry : noncopyable
+    {
+    public:
+        Entry()
+            :   prev_(nullptr),
+                next_(nullptr),
+                wheel_(nullptr),
+                lastTouched_(0),
+                timeoutTicks_(0)
+        {}
+        ~Entry();
+
+        //标记一次活跃 每次读事件都会调用 只有一次赋值
+        void touch() { lastTouched_ = wheel_->currentTick(); }
+
+        bool linked() const { return wheel_ != nullptr; }
+
+    private:
+        friend class TimingWheel;
+
+        Entry *prev_;
+        Entry *next_;
+        TimingWheel *wheel_;
+        int64_t lastTouched_;
+        int64_t timeoutTicks_;
+        ExpireCallback callback_;
+    };
+
+    static const size_t kDefaultNumSlots = 64;
+
+    TimingWheel(EventLoop *loop, double tickSeconds = 1.0, size_t numSlots = kDefaultNumSlots);
+    ~TimingWheel();
+
+    //注册entry  timeoutSeconds秒内没有touch就执行cb
+    void add(Entry *entry, double timeoutSeconds, ExpireCallback cb);
+    void remove(Entry *entry);
+
+    int64_t currentTick() const { return currentTick_; }
+    size_t size() const { return size_; }
+
+private:
+    void onTick();
+    static int64_t expireTick(const Entry *entry);
+    void link(Entry *entry, int64_t deadline);
+    static void unlink(Entry *entry);
+
+    EventLoop *loop_;
+    const double tickSeconds_;
+    //每个槽的哨兵节点  环形链表
+    std::vector<Entry> slots_;
+    int64_t currentTick_;
+    size_t size_;
+    TimerId tickTimer_;
+};
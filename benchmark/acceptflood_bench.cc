@@ -0,0 +1,224 @@
+#include <mymuduo/TcpServer.h>
+#include <mymuduo/EventLoop.h>
+#include <mymuduo/EventLoopThread.h>
+#include <mymuduo/InetAddress.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <sys/mman.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <unordered_map>
+#include <chrono>
+
+//替换epoll_wait 统计服务端loop被唤醒的次数 (客户端在子进程中)
+static std::atomic<long> g_epollWaits(0);
+
+extern "C" int epoll_wait(int epfd, struct epoll_event *events, int maxevents, int timeout)
+{
+    g_epollWaits.fetch_add(1, std::memory_order_relaxed);
+    return static_cast<int>(::syscall(SYS_epoll_pwait, epfd, events, maxevents, timeout, nullptr, 8));
+}
+
+static double cpuSeconds()
+{
+    rusage usage;
+    ::getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec
+        + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
+
+//在子进程里用clients个线程连接seconds秒  request为true时连上后等delayMs毫秒再发1字节
+//源地址轮流用127.0.0.2~201 避免短连接把临时端口用完  返回连接成功的次数
+//服务端可能已经没有fd了 结果通过共享内存传回 子进程把fd上限调回硬上限
+static long runClients(uint16_t port, double seconds, int clients, bool request, int delayMs)
+{
+    long *result = static_cast<long*>(::mmap(nullptr, sizeof(long), PROT_READ | PROT_WRITE,
+                                            MAP_SHARED | MAP_ANONYMOUS, -1, 0));
+    *result = 0;
+    pid_t pid = ::fork();
+    if(pid == 0)
+    {
+        rlimit limit;
+        ::getrlimit(RLIMIT_NOFILE, &limit);
+        limit.rlim_cur = limit.rlim_max;
+        ::setrlimit(RLIMIT_NOFILE, &limit);
+        std::atomic<long> connected(0);
+        std::atomic<unsigned> next(0);
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::duration<double>(seconds);
+        std::vector<std::thread> threads;
+        for(int c = 0; c < clients; ++c)
+        {
+            threads.emplace_back([&] {
+                sockaddr_in serverAddr = {};
+                serverAddr.sin_family = AF_INET;
+                serverAddr.sin_port = htons(port);
+                serverAddr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+                while(std::chrono::steady_clock::now() < deadline)
+                {
+                    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+                    sockaddr_in local = {};
+                    local.sin_family = AF_INET;
+                    local.sin_addr.s_addr = htonl(0x7f000002 + next++ % 200);
+                    ::bind(fd, reinterpret_cast<sockaddr*>(&local), sizeof local);
+                    //服务端不accept时backlog会满 connect不要一直等
+                    timeval timeout = { 0, 100 * 1000 };
+                    ::setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof timeout);
+                    ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof timeout);
+                    if(::connect(fd, reinterpret_cast<sockaddr*>(&serverAddr), sizeof serverAddr) == 0)
+                    {
+                        ++connected;
+                        if(request)
+                        {
+                            ::usleep(delayMs * 1000);
+                            char buf[16];
+                            ::write(fd, "q", 1);
+                            ::read(fd, buf, sizeof buf);
+                        }
+                    }
+                    ::close(fd);
+                }
+            });
+        }
+        for(std::thread &t : threads)
+        {
+            t.join();
+        }
+        *result = connected.load();
+        ::_exit(0);
+    }
+    ::waitpid(pid, nullptr, 0);
+    long connected = *result;
+    ::munmap(result, sizeof(long));
+    return connected;
+}
+
+//flood:     客户端不停地连接后马上关闭  统计每秒accept的连接数和每个连接的epoll_wait次数
+//exhausted: 服务端fd用完 统计loop的epoll_wait次数和CPU占用(以前EMFILE时监听fd一直可读 loop空转)
+//defer:     客户端连上20ms后才发请求 比较打开TCP_DEFER_ACCEPT前后 连接在服务端等请求的时间和epoll_wait次数
+int main(int argc, char *argv[])
+{
+    const double seconds = argc > 1 ? ::atof(argv[1]) : 2.0;
+    const int clients = 8;
+    Logger::setLogLevel(FATAL);
+
+    EventLoopThread loopThread;
+    EventLoop *loop = loopThread.startLoop();
+    std::atomic<long> accepted(0);
+    //只在loop线程中访问: 连接建立的时间 收到请求时累加等待的时间
+    std::unordered_map<const TcpConnection*, int64_t> connectTimes;
+    int64_t idleUs = 0;
+    long requests = 0;
+
+    uint16_t port = 9150;
+    const int deferSeconds[] = { 0, 0, 0, 5 };
+    const char *phases[] = { "flood", "exhausted", "defer off", "defer on" };
+    for(int p = 0; p < 4; ++p, ++port)
+    {
+        InetAddress addr(port);
+        TcpServer *server = nullptr;
+        std::atomic<bool> ready(false);
+        loop->runInLoop([&] {
+            server = new TcpServer(loop, addr, phases[p]);
+            server->setDeferAccept(deferSeconds[p]);
+            server->setConnectionCallback([&](const TcpConnectionPtr &conn) {
+                if(conn->connected())
+                {
+                    ++accepted;
+                    connectTimes[conn.get()] = Timestamp::monotonicMicroseconds();
+                }
+                else
+                {
+                    connectTimes.erase(conn.get());
+                }
+            });
+            server->setMessageCallback([&](const TcpConnectionPtr &conn, Buffer *buf, Timestamp) {
+                buf->retriveAll();
+                auto it = connectTimes.find(conn.get());
+                if(it != connectTimes.end())
+                {
+                    idleUs += Timestamp::monotonicMicroseconds() - it->second;
+                    ++requests;
+                    connectTimes.erase(it);
+                }
+                conn->shutdown();
+            });
+            server->start();
+            ready = true;
+        });
+        while(!ready.load())
+        {
+            ::usleep(1000);
+        }
+
+        //占满fd 只留很少几个
+        std::vector<int> fillers;
+        rlimit oldLimit;
+        ::getrlimit(RLIMIT_NOFILE, &oldLimit);
+        if(p == 1)
+        {
+            rlimit limit = oldLimit;
+            limit.rlim_cur = 256;
+            ::setrlimit(RLIMIT_NOFILE, &limit);
+            int fd;
+            while((fd = ::open("/dev/null", O_RDONLY)) >= 0)
+            {
+                fillers.push_back(fd);
+            }
+        }
+
+        accepted = 0;
+        idleUs = 0;
+        requests = 0;
+        long waitsBefore = g_epollWaits.load();
+        double cpuBefore = cpuSeconds();
+        auto start = std::chrono::steady_clock::now();
+        long connected = runClients(port, seconds, clients, p >= 2, 20);
+        double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        double cpu = cpuSeconds() - cpuBefore;
+        long waits = g_epollWaits.load() - waitsBefore;
+
+        if(p == 1)
+        {
+            printf("%-9s: %8ld connects  %8ld accepted  %10.0f epoll_wait/s  server cpu %3.0f%%\n",
+                    phases[p], connected, accepted.load(), waits / sec, cpu / sec * 100);
+            for(int fd : fillers)
+            {
+                ::close(fd);
+            }
+            ::setrlimit(RLIMIT_NOFILE, &oldLimit);
+        }
+        else if(p == 0)
+        {
+            printf("%-9s: %8.0f accepts/s  %.3f epoll_wait/accept  server cpu %3.0f%%\n",
+                    phases[p], accepted.load() / sec, static_cast<double>(waits) / accepted.load(),
+                    cpu / sec * 100);
+        }
+
+        ready = false;
+        loop->runInLoop([&] {
+            if(p >= 2)
+            {
+                printf("%-9s: %8.0f accepts/s  %.3f epoll_wait/accept  %6.2f ms idle before request\n",
+                        phases[p], accepted.load() / sec, static_cast<double>(waits) / accepted.load(),
+                        requests > 0 ? idleUs / 1000.0 / requests : 0.0);
+            }
+            delete server;
+            connectTimes.clear();
+            ready = true;
+        });
+        while(!ready.load())
+        {
+            ::usleep(1000);
+        }
+    }
+    return 0;
+}
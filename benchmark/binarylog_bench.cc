@@ -0,0 +1,63 @@
+#include <mymuduo/Logger.h>
+#include <mymuduo/AsyncLogging.h>
+#include <mymuduo/BinaryLogging.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <chrono>
+#include <unistd.h>
+
+//调用线程上每条日志的开销: LOG_INFO(snprintf + AsyncLogging) 对比 BLOG_INFO(二进制记录)
+AsyncLogging *g_asyncLog = nullptr;
+
+void asyncOutput(const char *msg, size_t len)
+{
+    g_asyncLog->append(msg, len);
+}
+
+template<typename F>
+double nsPerCall(int iters, F f)
+{
+    auto start = std::chrono::steady_clock::now();
+    for(int i = 0; i < iters; ++i)
+    {
+        f(i);
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count() / iters;
+}
+
+int main(int argc, char *argv[])
+{
+    std::string prefix = argc > 1 ? argv[1] : "/tmp/binarylog_bench";
+    //每批写入的条数不超过环形缓冲区容量 批与批之间让后端取走数据 测的是调用线程的开销
+    const int kBatch = 10000;
+    const int kBatches = argc > 2 ? atoi(argv[2]) : 100;
+
+    AsyncLogging log(prefix + ".log");
+    log.start();
+    g_asyncLog = &log;
+    Logger::setOutput(asyncOutput);
+    BinaryLogging::start(prefix + ".blog", 10);
+
+    double textNs = 0.0;
+    double binaryNs = 0.0;
+    for(int b = 0; b < kBatches; ++b)
+    {
+        textNs += nsPerCall(kBatch, [](int i){
+            LOG_INFO("fd = %d events = %d index = %d name = %s", i, i & 7, 1, "conn");
+        });
+        binaryNs += nsPerCall(kBatch, [](int i){
+            BLOG_INFO("fd = %d events = %d index = %d name = %s", i, i & 7, 1, "conn");
+        });
+        usleep(20 * 1000);
+    }
+
+    BinaryLogging::stop();
+    log.stop();
+    printf("LOG_INFO  (snprintf + async): %.1f ns/call\n", textNs / kBatches);
+    printf("BLOG_INFO (binary ring):      %.1f ns/call\n", binaryNs / kBatches);
+    printf("binary records dropped: %lu\n", static_cast<unsigned long>(BinaryLogging::dropped()));
+    return 0;
+}
@@ -0,0 +1,126 @@
+#include <mymuduo/Buffer.h>
+#include <mymuduo/BufferPool.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <memory>
+#include <vector>
+#include <chrono>
+
+//模拟连接的建立和断开: 维持live个连接 每轮每个连接收到一条随机大小的消息并取走
+//每轮有1/8的连接断开 换成新连接 统计每秒处理的消息数和进程的RSS
+//baseline是原来基于std::vector<char>的Buffer: 构造时分配并清零 数据取走后存储不释放
+class VectorBuffer
+{
+public:
+    static const size_t kCheapPrepend = 8;
+    VectorBuffer() : buffer_(kCheapPrepend + 1024), readerIndex_(kCheapPrepend), writerIndex_(kCheapPrepend) {}
+
+    void append(const char *data, size_t len)
+    {
+        if(buffer_.size() - writerIndex_ < len)
+        {
+            buffer_.resize(writerIndex_ + len);
+        }
+        memcpy(&buffer_[writerIndex_], data, len);
+        writerIndex_ += len;
+    }
+    void retriveAll() { readerIndex_ = writerIndex_ = kCheapPrepend; }
+    size_t readableBytes() const { return writerIndex_ - readerIndex_; }
+
+private:
+    std::vector<char> buffer_;
+    size_t readerIndex_;
+    size_t writerIndex_;
+};
+
+long rssKB()
+{
+    FILE *fp = ::fopen("/proc/self/status", "r");
+    char line[256];
+    long kb = 0;
+    while(fp != nullptr && ::fgets(line, sizeof line, fp) != nullptr)
+    {
+        if(::strncmp(line, "VmRSS:", 6) == 0)
+        {
+            kb = ::atol(line + 6);
+        }
+    }
+    if(fp != nullptr)
+    {
+        ::fclose(fp);
+    }
+    return kb;
+}
+
+//大部分消息很小 少数是大块数据
+size_t messageSize(unsigned *seed)
+{
+    unsigned r = ::rand_r(seed) % 100;
+    if(r < 80) return 64 + ::rand_r(seed) % 512;
+    if(r < 98) return 1024 + ::rand_r(seed) % 8192;
+    return 64 * 1024 + ::rand_r(seed) % (192 * 1024);
+}
+
+template<typename BufferType>
+void run(const char *name, int live, int rounds)
+{
+    std::vector<std::unique_ptr<BufferType>> conns(live);
+    for(auto &c : conns)
+    {
+        c.reset(new BufferType);
+    }
+    std::vector<char> data(256 * 1024, 'x');
+    unsigned seed = 1;
+    long messages = 0;
+    long peakRss = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for(int round = 0; round < rounds; ++round)
+    {
+        for(int i = 0; i < live; ++i)
+        {
+            conns[i]->append(data.data(), messageSize(&seed));
+            ++messages;
+            //一半的连接消息到齐后立即处理 另一半留到下一轮(半包)
+            if((i + round) & 1)
+            {
+                conns[i]->retriveAll();
+            }
+        }
+        for(int i = 0; i < live / 8; ++i)
+        {
+            conns[::rand_r(&seed) % live].reset(new BufferType);
+        }
+        long rss = rssKB();
+        peakRss = rss > peakRss ? rss : peakRss;
+    }
+    double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    printf("%-14s %6d conns  %10.0f msgs/s  peak RSS %7ld KB  final RSS %7ld KB  slab %6zu KB\n",
+            name, live, messages / sec, peakRss, rssKB(), BufferPool::slabBytes() / 1024);
+}
+
+int main(int argc, char *argv[])
+{
+    //RSS是整个进程的 每次只跑一种实现
+    const char *mode = argc > 1 ? argv[1] : "pool";
+    int live = argc > 2 ? ::atoi(argv[2]) : 10000;
+    int rounds = argc > 3 ? ::atoi(argv[3]) : 200;
+
+    if(::strcmp(mode, "vector") == 0)
+    {
+        run<VectorBuffer>("vector", live, rounds);
+        return 0;
+    }
+    if(::strcmp(mode, "thp") == 0)
+    {
+        BufferPool::setHugePageMode(BufferPool::kTransparentHugePages);
+    }
+    else if(::strcmp(mode, "hugetlb") == 0)
+    {
+        BufferPool::setHugePageMode(BufferPool::kHugeTLB);
+    }
+    run<Buffer>(mode, live, rounds);
+    return 0;
+}
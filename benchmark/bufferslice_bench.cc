@@ -0,0 +1,97 @@
+#include <mymuduo/Buffer.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <new>
+#include <string>
+#include <vector>
+#include <chrono>
+
+//替换全局operator new 统计每条消息触发的堆分配次数
+static long g_allocs = 0;
+
+void* operator new(size_t size)
+{
+    ++g_allocs;
+    void *p = ::malloc(size);
+    if(p == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void *p) noexcept
+{
+    ::free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+    ::free(p);
+}
+
+//模拟onMessage: 每条消息append进Buffer 再用不同的方式取走
+//held表示消息要在回调之后继续持有(例如交给工作线程) 每16条释放一次
+template<typename Consume>
+void run(const char *name, size_t msgSize, int messages, Consume consume)
+{
+    std::string msg(msgSize, 'x');
+    Buffer buf;
+    long checksum = 0;
+    long allocsBefore = g_allocs;
+    auto start = std::chrono::steady_clock::now();
+    for(int i = 0; i < messages; ++i)
+    {
+        buf.append(msg.data(), msg.size());
+        checksum += consume(&buf);
+    }
+    double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    printf("%-26s %6zu B: %6.2f allocs/msg  %7.1f ns/msg  (checksum %ld)\n", name, msgSize,
+            static_cast<double>(g_allocs - allocsBefore) / messages, sec * 1e9 / messages, checksum);
+}
+
+int main()
+{
+    const int messages = 1000000;
+    const size_t sizes[] = { 64, 1024, 16 * 1024 };
+    for(size_t size : sizes)
+    {
+        std::vector<std::string> strings;
+        strings.reserve(16);
+        run("retriveAllAsString", size, messages, [&](Buffer *buf) {
+            std::string s = buf->retriveAllAsString();
+            return static_cast<long>(s[s.size() - 1]);
+        });
+        run("retriveAllAsString(held)", size, messages, [&](Buffer *buf) {
+            strings.push_back(buf->retriveAllAsString());
+            long c = strings.back()[0];
+            if(strings.size() == 16) strings.clear();
+            return c;
+        });
+        run("toStringPiece", size, messages, [](Buffer *buf) {
+            StringPiece piece = buf->toStringPiece();
+            long c = piece[piece.size() - 1];
+            buf->retriveAll();
+            return c;
+        });
+
+        std::vector<BufferSlice> slices;
+        slices.reserve(16);
+        run("retriveAllAsSlice(held)", size, messages, [&](Buffer *buf) {
+            slices.push_back(buf->retriveAllAsSlice());
+            long c = slices.back().data()[0];
+            if(slices.size() == 16) slices.clear();
+            return c;
+        });
+        //一次读到的数据里有两条消息 前一半用共享存储的slice取走
+        run("retriveAsSlice(held)", size, messages, [&](Buffer *buf) {
+            slices.push_back(buf->retriveAsSlice(buf->readableBytes() / 2));
+            slices.push_back(buf->retriveAllAsSlice());
+            long c = slices.back().data()[0];
+            if(slices.size() >= 16) slices.clear();
+            return c;
+        });
+    }
+    return 0;
+}
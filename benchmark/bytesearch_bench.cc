@@ -0,0 +1,101 @@
+#include <mymuduo/Buffer.h>
+#include <mymuduo/ByteSearch.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <string>
+#include <chrono>
+
+//在len字节的文本中查找只出现在末尾的分隔符 比较Buffer的查找和memchr/std::search/std::find_first_of
+//最后模拟半包: 数据分块到达 每到一块就查找一次CRLF 对比从头重扫和从保存的offset继续
+template<typename Func>
+void bench(const char *name, size_t len, int iterations, Func func)
+{
+    size_t found = 0;
+    auto start = std::chrono::steady_clock::now();
+    for(int i = 0; i < iterations; ++i)
+    {
+        found += func();
+        asm volatile("" ::: "memory");
+    }
+    double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    printf("  %-24s %8.2f GB/s  %8.1f ns/search  (pos %zu)\n", name,
+            static_cast<double>(len) * iterations / sec / 1e9, sec * 1e9 / iterations, found / iterations);
+}
+
+void runSize(size_t len)
+{
+    std::string text;
+    while(text.size() < len)
+    {
+        text += "GET /index.html HTTP/1.1 Host: example.com User-Agent: bench\r";
+    }
+    text.resize(len - 2);
+    text += "\r\n";
+
+    Buffer buf;
+    buf.append(text.data(), text.size());
+    const char *b = buf.peek();
+    const char *e = b + buf.readableBytes();
+    const int iterations = static_cast<int>(std::max<size_t>(1, (1UL << 30) / len));
+    static const char kCRLF[] = "\r\n";
+    static const char kSet[] = "\n<>&";
+
+    printf("%zu bytes (%s)\n", len, ByteSearch::implementation());
+    bench("Buffer::findEOL", len, iterations, [&] { return buf.findEOL() - b; });
+    bench("memchr", len, iterations, [&] {
+        return static_cast<const char*>(memchr(b, '\n', e - b)) - b; });
+    bench("Buffer::findCRLF", len, iterations, [&] { return buf.findCRLF() - b; });
+    bench("std::search CRLF", len, iterations, [&] {
+        return std::search(b, e, kCRLF, kCRLF + 2) - b; });
+    bench("Buffer::findAnyOf(4)", len, iterations, [&] { return buf.findAnyOf(kSet, 4) - b; });
+    bench("std::find_first_of(4)", len, iterations, [&] {
+        return std::find_first_of(b, e, kSet, kSet + 4) - b; });
+}
+
+//一行分成chunk字节的小块陆续到达 每到一块查找一次行尾
+void runPartial(size_t lineLen, size_t chunk)
+{
+    std::string line(lineLen - 2, 'x');
+    line += "\r\n";
+    const int rounds = 20;
+
+    for(int resume = 0; resume < 2; ++resume)
+    {
+        long scanned = 0;
+        auto start = std::chrono::steady_clock::now();
+        for(int r = 0; r < rounds; ++r)
+        {
+            Buffer buf;
+            size_t offset = 0;
+            for(size_t pos = 0; pos < line.size(); pos += chunk)
+            {
+                buf.append(line.data() + pos, std::min(chunk, line.size() - pos));
+                const char *crlf = buf.findCRLF(resume ? offset : 0);
+                scanned += buf.readableBytes() - (resume ? offset : 0);
+                if(crlf != nullptr)
+                {
+                    buf.retrive(crlf + 2 - buf.peek());
+                    break;
+                }
+                offset = buf.readableBytes() - 1;
+            }
+        }
+        double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        printf("partial %zu B line in %zu B chunks, %-8s: %8.1f us/line  %10ld bytes scanned/line\n",
+                lineLen, chunk, resume ? "resume" : "rescan", sec * 1e6 / rounds, scanned / rounds);
+    }
+}
+
+int main()
+{
+    const size_t sizes[] = { 64, 1024, 16 * 1024, 1024 * 1024 };
+    for(size_t len : sizes)
+    {
+        runSize(len);
+    }
+    runPartial(256 * 1024, 1460);
+    return 0;
+}
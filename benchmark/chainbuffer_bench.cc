@@ -0,0 +1,64 @@
+#include <mymuduo/Buffer.h>
+#include <mymuduo/ChainBuffer.h>
+
+#include <stdio.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <vector>
+#include <chrono>
+
+//64MB数据流过 Buffer(连续存储) 和 ChainBuffer(分段) 的耗时
+//  bulk:   先以4KB为单位追加完64MB 再writeFd到/dev/null直到写完
+//  stream: 每次追加16KB 取走12KB 可读数据一直在增长 模拟对端消费得比生产慢
+const size_t kTotal = 64 * 1024 * 1024;
+
+template<typename B>
+double bulk(int fd)
+{
+    std::vector<char> piece(4096, 'x');
+    auto start = std::chrono::steady_clock::now();
+    B buf;
+    for(size_t n = 0; n < kTotal; n += piece.size())
+    {
+        buf.append(piece.data(), piece.size());
+    }
+    int saveErrno = 0;
+    while(buf.readableBytes() > 0)
+    {
+        if(buf.writeFd(fd, &saveErrno) < 0)
+        {
+            break;
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double>(end - start).count();
+}
+
+template<typename B>
+double stream()
+{
+    std::vector<char> piece(16 * 1024, 'x');
+    auto start = std::chrono::steady_clock::now();
+    B buf;
+    for(size_t n = 0; n < kTotal; n += piece.size())
+    {
+        buf.append(piece.data(), piece.size());
+        buf.retrive(12 * 1024);
+    }
+    buf.retriveAll();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double>(end - start).count();
+}
+
+int main()
+{
+    int fd = ::open("/dev/null", O_WRONLY);
+    double mb = kTotal / (1024.0 * 1024.0);
+    printf("%-8s %-12s %10s\n", "pattern", "buffer", "MB/s");
+    printf("%-8s %-12s %10.0f\n", "bulk", "Buffer", mb / bulk<Buffer>(fd));
+    printf("%-8s %-12s %10.0f\n", "bulk", "ChainBuffer", mb / bulk<ChainBuffer>(fd));
+    printf("%-8s %-12s %10.0f\n", "stream", "Buffer", mb / stream<Buffer>());
+    printf("%-8s %-12s %10.0f\n", "stream", "ChainBuffer", mb / stream<ChainBuffer>());
+    ::close(fd);
+    return 0;
+}
@@ -0,0 +1,261 @@
+#include <mymuduo/TcpServer.h>
+#include <mymuduo/EventLoop.h>
+#include <mymuduo/EventLoopThread.h>
+#include <mymuduo/InetAddress.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <unistd.h>
+#include <dlfcn.h>
+#include <poll.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+#include <chrono>
+
+//统计服务端的系统调用: poller(epoll_wait epoll_ctl io_uring_enter)和收发数据(read readv write writev)
+//客户端用recv/send 不计入
+static std::atomic<long> g_pollerCalls(0);
+static std::atomic<long> g_dataCalls(0);
+
+extern "C" ssize_t read(int fd, void *buf, size_t count)
+{
+    g_dataCalls.fetch_add(1, std::memory_order_relaxed);
+    return ::syscall(SYS_read, fd, buf, count);
+}
+
+extern "C" ssize_t readv(int fd, const struct iovec *iov, int iovcnt)
+{
+    g_dataCalls.fetch_add(1, std::memory_order_relaxed);
+    return ::syscall(SYS_readv, fd, iov, iovcnt);
+}
+
+extern "C" ssize_t write(int fd, const void *buf, size_t count)
+{
+    g_dataCalls.fetch_add(1, std::memory_order_relaxed);
+    return ::syscall(SYS_write, fd, buf, count);
+}
+
+extern "C" ssize_t writev(int fd, const struct iovec *iov, int iovcnt)
+{
+    g_dataCalls.fetch_add(1, std::memory_order_relaxed);
+    return ::syscall(SYS_writev, fd, iov, iovcnt);
+}
+
+extern "C" int epoll_wait(int epfd, struct epoll_event *events, int maxevents, int timeout)
+{
+    g_pollerCalls.fetch_add(1, std::memory_order_relaxed);
+    return static_cast<int>(::syscall(SYS_epoll_pwait, epfd, events, maxevents, timeout, nullptr, 8));
+}
+
+extern "C" int epoll_ctl(int epfd, int op, int fd, struct epoll_event *event)
+{
+    g_pollerCalls.fetch_add(1, std::memory_order_relaxed);
+    return static_cast<int>(::syscall(SYS_epoll_ctl, epfd, op, fd, event));
+}
+
+extern "C" long syscall(long number, ...)
+{
+    typedef long (*SyscallFunc)(long, ...);
+    static SyscallFunc realSyscall = reinterpret_cast<SyscallFunc>(::dlsym(RTLD_NEXT, "syscall"));
+    va_list ap;
+    va_start(ap, number);
+    long a[6];
+    for(int i = 0; i < 6; ++i)
+    {
+        a[i] = va_arg(ap, long);
+    }
+    va_end(ap);
+    if(number == SYS_io_uring_enter)
+    {
+        g_pollerCalls.fetch_add(1, std::memory_order_relaxed);
+    }
+    return realSyscall(number, a[0], a[1], a[2], a[3], a[4], a[5]);
+}
+
+//大块数据的完整性: 服务端连续send kBulkSends次1MB的数据 客户端慢慢读并检查每个字节
+//发送被拆成多个send时 短写不能让后面的数据先发出去
+//返回不对的字节数  firstBad为第一个不对的偏移
+static const int kBulkSends = 16;
+static const size_t kBulkSize = 1024 * 1024;
+
+static char bulkByte(size_t offset)
+{
+    return static_cast<char>(offset % 251);
+}
+
+static long checkBulk(EventLoop *loop, uint16_t port, bool completionIo, long *firstBad)
+{
+    InetAddress addr(port);
+    std::unique_ptr<TcpServer> server(new TcpServer(loop, addr, "bulk"));
+    server->setCompletionIo(completionIo);
+    server->setConnectionCallback([](const TcpConnectionPtr &conn) {
+        if(conn->connected())
+        {
+            std::string data(kBulkSize, 0);
+            for(int i = 0; i < kBulkSends; ++i)
+            {
+                for(size_t j = 0; j < kBulkSize; ++j)
+                {
+                    data[j] = bulkByte(i * kBulkSize + j);
+                }
+                conn->send(data);
+            }
+            conn->shutdown();
+        }
+    });
+    loop->runInLoop([&server] { server->start(); });
+
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    //接收缓冲区小一些 服务端的send会出现短写
+    int rcvbuf = 64 * 1024;
+    ::setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof rcvbuf);
+    sockaddr_in serverAddr = {};
+    serverAddr.sin_family = AF_INET;
+    serverAddr.sin_port = htons(port);
+    serverAddr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    while(::connect(fd, reinterpret_cast<sockaddr*>(&serverAddr), sizeof serverAddr) < 0)
+    {
+        ::usleep(1000);
+    }
+    char buf[16 * 1024];
+    size_t offset = 0;
+    long bad = 0;
+    *firstBad = -1;
+    ssize_t n;
+    while((n = ::recv(fd, buf, sizeof buf, 0)) > 0)
+    {
+        for(ssize_t i = 0; i < n; ++i, ++offset)
+        {
+            if(buf[i] != bulkByte(offset))
+            {
+                if(bad++ == 0)
+                {
+                    *firstBad = static_cast<long>(offset);
+                }
+            }
+        }
+        ::usleep(100);
+    }
+    ::close(fd);
+    bad += static_cast<long>(kBulkSends * kBulkSize) - static_cast<long>(offset);
+    //TcpServer在loop线程中析构
+    std::atomic<bool> done(false);
+    loop->runInLoop([&] { server.reset(); done = true; });
+    while(!done.load())
+    {
+        ::usleep(1000);
+    }
+    return bad;
+}
+
+//conns个连接各自一问一答地发msgSize字节的消息 客户端用poll驱动
+//比较 epoll就绪通知 / io_uring就绪通知 / io_uring完成模式(multishot recv + provided buffer + send)
+//每条消息服务端的系统调用次数和吞吐  最后检查大块数据的完整性
+int main(int argc, char *argv[])
+{
+    const double seconds = argc > 1 ? ::atof(argv[1]) : 2.0;
+    const size_t msgSize = 64;
+    Logger::setLogLevel(WARN);
+
+    const char *modes[] = { "epoll", "uring", "uring-cio" };
+    const int connCounts[] = { 1, 16, 256 };
+    for(int m = 0; m < 3; ++m)
+    {
+        //Poller::newDefaultPoller在EventLoop构造时读环境变量
+        if(m > 0)
+        {
+            ::setenv("MUDUO_USE_URING", "1", 1);
+        }
+        EventLoopThread loopThread;
+        EventLoop *loop = loopThread.startLoop();
+        const uint16_t port = static_cast<uint16_t>(9131 + m);
+        InetAddress addr(port);
+        TcpServer server(loop, addr, modes[m]);
+        server.setCompletionIo(m == 2);
+        server.setConnectionCallback([](const TcpConnectionPtr&) {});
+        server.setMessageCallback([](const TcpConnectionPtr &conn, Buffer *buf, Timestamp) {
+            conn->send(buf);
+        });
+        loop->runInLoop([&server] { server.start(); });
+
+        for(int conns : connCounts)
+        {
+            std::vector<pollfd> fds(conns);
+            for(int i = 0; i < conns; ++i)
+            {
+                int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+                sockaddr_in serverAddr = {};
+                serverAddr.sin_family = AF_INET;
+                serverAddr.sin_port = htons(port);
+                serverAddr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+                while(::connect(fd, reinterpret_cast<sockaddr*>(&serverAddr), sizeof serverAddr) < 0)
+                {
+                    ::usleep(1000);
+                }
+                fds[i].fd = fd;
+                fds[i].events = POLLIN;
+            }
+            ::usleep(50000);
+
+            const std::string msg(msgSize, 'm');
+            char buf[4096];
+            long messages = 0;
+            long pollerBefore = g_pollerCalls.load();
+            long dataBefore = g_dataCalls.load();
+            auto start = std::chrono::steady_clock::now();
+            auto deadline = start + std::chrono::duration<double>(seconds);
+            for(pollfd &p : fds)
+            {
+                ::send(p.fd, msg.data(), msg.size(), 0);
+            }
+            while(std::chrono::steady_clock::now() < deadline)
+            {
+                int n = ::poll(fds.data(), fds.size(), 1000);
+                for(int i = 0; i < conns && n > 0; ++i)
+                {
+                    if(fds[i].revents & POLLIN)
+                    {
+                        --n;
+                        ssize_t got = ::recv(fds[i].fd, buf, sizeof buf, 0);
+                        //消息很小 一次就能读完整条回显
+                        if(got > 0)
+                        {
+                            ++messages;
+                            ::send(fds[i].fd, msg.data(), msg.size(), 0);
+                        }
+                    }
+                }
+            }
+            double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            long pollerCalls = g_pollerCalls.load() - pollerBefore;
+            long dataCalls = g_dataCalls.load() - dataBefore;
+            printf("%-9s %3d conns: %9.0f msgs/s  %.3f poller + %.3f data syscalls/msg\n", modes[m], conns,
+                    messages / sec, static_cast<double>(pollerCalls) / messages,
+                    static_cast<double>(dataCalls) / messages);
+            //每个连接还有一条回显在路上 读完再关 避免服务端收到RST
+            for(pollfd &p : fds)
+            {
+                ::recv(p.fd, buf, sizeof buf, 0);
+                ::close(p.fd);
+            }
+            ::usleep(50000);
+        }
+
+        long firstBad;
+        long bad = checkBulk(loop, static_cast<uint16_t>(9135 + m), m == 2, &firstBad);
+        printf("%-9s bulk %d x %zu bytes: %ld bytes wrong", modes[m], kBulkSends, kBulkSize, bad);
+        if(bad > 0)
+        {
+            printf(" (first at offset %ld)", firstBad);
+        }
+        printf("\n");
+    }
+    return 0;
+}
@@ -0,0 +1,140 @@
+#include <mymuduo/TcpServer.h>
+#include <mymuduo/EventLoop.h>
+#include <mymuduo/EventLoopThread.h>
+#include <mymuduo/InetAddress.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <chrono>
+
+//替换epoll_wait 统计loop被唤醒的次数
+static std::atomic<long> g_epollWaits(0);
+
+extern "C" int epoll_wait(int epfd, struct epoll_event *events, int maxevents, int timeout)
+{
+    g_epollWaits.fetch_add(1, std::memory_order_relaxed);
+    return static_cast<int>(::syscall(SYS_epoll_pwait, epfd, events, maxevents, timeout, nullptr, 8));
+}
+
+static int connectTo(uint16_t port)
+{
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    while(::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof addr) < 0)
+    {
+        ::usleep(1000);
+    }
+    return fd;
+}
+
+//upload:   客户端连续写totalMB 服务端读走丢弃
+//download: 服务端在WriteCompleteCallback里一块块(16MB)地发 客户端读
+//分别用水平触发和边缘触发的TcpServer跑 比较epoll_wait次数和吞吐
+int main(int argc, char *argv[])
+{
+    const long totalBytes = (argc > 1 ? ::atol(argv[1]) : 1024) << 20;
+    const int chunk = 64 * 1024;
+    //下载时每块远大于socket发送缓冲区 大部分数据经outputBuffer由handleWrite发出
+    const long bigChunk = 16 << 20;
+    Logger::setLogLevel(WARN);
+
+    EventLoopThread loopThread;
+    EventLoop *loop = loopThread.startLoop();
+
+    std::atomic<long> received(0);
+    std::atomic<long> toSend(0);
+    const std::string block(chunk, 'u');
+    const std::string bigBlock(bigChunk, 'd');
+
+    const bool modes[] = { false, true };
+    for(bool edge : modes)
+    {
+        const uint16_t port = edge ? 9128 : 9127;
+        InetAddress addr(port);
+        TcpServer server(loop, addr, edge ? "et" : "lt");
+        server.setEdgeTriggered(edge);
+        server.setConnectionCallback([](const TcpConnectionPtr&) {});
+        server.setMessageCallback([&](const TcpConnectionPtr &conn, Buffer *buf, Timestamp) {
+            received += static_cast<long>(buf->readableBytes());
+            buf->retriveAll();
+            //download模式下客户端发一个字节开始
+            if(toSend.load() > 0 && conn->connected())
+            {
+                toSend -= bigChunk;
+                conn->send(bigBlock);
+            }
+        });
+        server.setWriteCompleteCallback([&](const TcpConnectionPtr &conn) {
+            if(toSend.load() > 0)
+            {
+                toSend -= bigChunk;
+                conn->send(bigBlock);
+            }
+        });
+        loop->runInLoop([&server] { server.start(); });
+
+        //upload
+        {
+            int fd = connectTo(port);
+            ::usleep(20000);
+            received = 0;
+            long waitsBefore = g_epollWaits.load();
+            auto start = std::chrono::steady_clock::now();
+            for(long sent = 0; sent < totalBytes; sent += chunk)
+            {
+                ::write(fd, block.data(), block.size());
+            }
+            while(received.load() < totalBytes)
+            {
+                ::usleep(100);
+            }
+            double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            long waits = g_epollWaits.load() - waitsBefore;
+            printf("%s upload   %5ld MB: %8.1f MB/s  %8ld epoll_wait  %7.1f KB/wakeup\n", edge ? "ET" : "LT",
+                    totalBytes >> 20, totalBytes / sec / (1 << 20), waits,
+                    static_cast<double>(totalBytes) / waits / 1024);
+            ::close(fd);
+            ::usleep(20000);
+        }
+
+        //download
+        {
+            int fd = connectTo(port);
+            ::usleep(20000);
+            toSend = totalBytes;
+            long waitsBefore = g_epollWaits.load();
+            auto start = std::chrono::steady_clock::now();
+            ::write(fd, "x", 1);
+            char buf[65536];
+            long got = 0;
+            while(got < totalBytes)
+            {
+                ssize_t n = ::read(fd, buf, sizeof buf);
+                if(n <= 0)
+                {
+                    break;
+                }
+                got += n;
+            }
+            double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            long waits = g_epollWaits.load() - waitsBefore;
+            printf("%s download %5ld MB: %8.1f MB/s  %8ld epoll_wait  %7.1f KB/wakeup\n", edge ? "ET" : "LT",
+                    totalBytes >> 20, got / sec / (1 << 20), waits,
+                    static_cast<double>(got) / waits / 1024);
+            toSend = 0;
+            ::close(fd);
+            ::usleep(20000);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,139 @@
+#include <mymuduo/TcpServer.h>
+#include <mymuduo/EventLoop.h>
+#include <mymuduo/EventLoopThread.h>
+#include <mymuduo/InetAddress.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <chrono>
+
+//替换epoll_ctl 统计进程中真正进入内核的次数
+static std::atomic<long> g_epollCtls(0);
+
+extern "C" int epoll_ctl(int epfd, int op, int fd, struct epoll_event *event)
+{
+    g_epollCtls.fetch_add(1, std::memory_order_relaxed);
+    return static_cast<int>(::syscall(SYS_epoll_ctl, epfd, op, fd, event));
+}
+
+static int connectTo(uint16_t port)
+{
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    //接收窗口调小 服务端的write写不完 需要关注EPOLLOUT
+    int rcvbuf = 16 * 1024;
+    ::setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof rcvbuf);
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    while(::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof addr) < 0)
+    {
+        ::usleep(1000);
+    }
+    return fd;
+}
+
+static void readAll(int fd, long bytes)
+{
+    char buf[65536];
+    while(bytes > 0)
+    {
+        ssize_t n = ::read(fd, buf, sizeof buf);
+        if(n <= 0)
+        {
+            break;
+        }
+        bytes -= n;
+    }
+}
+
+//stream:   服务端在WriteCompleteCallback里发下一块 (文件下载的写法)
+//pipeline: 客户端一次发出depth个请求 每个请求回一个response字节的响应
+//统计每个响应(块)平均调用了多少次epoll_ctl
+int main(int argc, char *argv[])
+{
+    const int count = argc > 1 ? ::atoi(argv[1]) : 2000;
+    const uint16_t port = 9126;
+    Logger::setLogLevel(WARN);
+
+    EventLoopThread loopThread;
+    EventLoop *loop = loopThread.startLoop();
+
+    std::atomic<int> chunkSize(0);
+    std::atomic<int> chunksLeft(0);
+    std::atomic<int> responseSize(0);
+    InetAddress addr(port);
+    TcpServer server(loop, addr, "epollctl");
+    server.setConnectionCallback([](const TcpConnectionPtr&) {});
+    server.setMessageCallback([&](const TcpConnectionPtr &conn, Buffer *buf, Timestamp) {
+        //每个字节是一个请求
+        size_t requests = buf->readableBytes();
+        buf->retriveAll();
+        for(size_t i = 0; i < requests; ++i)
+        {
+            conn->send(std::string(responseSize.load(), 'r'));
+        }
+    });
+    server.setWriteCompleteCallback([&](const TcpConnectionPtr &conn) {
+        if(chunksLeft.load() > 0)
+        {
+            --chunksLeft;
+            conn->send(std::string(chunkSize.load(), 's'));
+        }
+    });
+    loop->runInLoop([&server] { server.start(); });
+
+    const int chunks[] = { 4096, 65536, 1 << 20 };
+    for(int size : chunks)
+    {
+        int fd = connectTo(port);
+        ::usleep(20000);    //等连接建立 注册读事件的epoll_ctl不计入
+        chunkSize = size;
+        chunksLeft = count - 1;
+        long before = g_epollCtls.load();
+        auto start = std::chrono::steady_clock::now();
+        //第一块由一个请求触发 后面的由WriteCompleteCallback接着发
+        responseSize = size;
+        ::write(fd, "x", 1);
+        readAll(fd, static_cast<long>(size) * count);
+        double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        printf("stream   %7d B x %d: %5.2f epoll_ctl/chunk  %8.1f MB/s\n", size, count,
+                static_cast<double>(g_epollCtls.load() - before) / count,
+                static_cast<double>(size) * count / sec / (1 << 20));
+        chunksLeft = 0;
+        ::close(fd);
+        ::usleep(20000);
+    }
+
+    const int depths[] = { 1, 16 };
+    for(int depth : depths)
+    {
+        const int size = 1 << 20;
+        int fd = connectTo(port);
+        ::usleep(20000);
+        responseSize = size;
+        const int batches = count / depth;
+        std::string requests(depth, 'q');
+        long before = g_epollCtls.load();
+        auto start = std::chrono::steady_clock::now();
+        for(int i = 0; i < batches; ++i)
+        {
+            ::write(fd, requests.data(), requests.size());
+            readAll(fd, static_cast<long>(size) * depth);
+        }
+        double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        const int responses = batches * depth;
+        printf("pipeline %7d B depth %2d: %5.2f epoll_ctl/response  %8.0f responses/s\n", size, depth,
+                static_cast<double>(g_epollCtls.load() - before) / responses, responses / sec);
+        ::close(fd);
+        ::usleep(20000);
+    }
+    return 0;
+}
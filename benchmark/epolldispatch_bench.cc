@@ -0,0 +1,129 @@
+#include <mymuduo/EventLoop.h>
+#include <mymuduo/EpollPoller.h>
+#include <mymuduo/Channel.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <algorithm>
+#include <random>
+#include <memory>
+#include <vector>
+#include <chrono>
+
+//注册registered个eventfd 随机挑active个置为可读(LT模式下一直就绪)
+//反复poll 统计每个就绪事件的平均耗时  再用同样的fd集合直接epoll_wait作为对照
+//两者之差就是Poller把事件分发到Channel的开销
+int main(int argc, char *argv[])
+{
+    int registered = argc > 1 ? ::atoi(argv[1]) : 100000;
+    const int rounds = argc > 2 ? ::atoi(argv[2]) : 2000;
+
+    //尽量把fd上限提到需要的数量 提不上去就按上限缩小规模
+    rlimit rl;
+    ::getrlimit(RLIMIT_NOFILE, &rl);
+    rl.rlim_cur = std::max<rlim_t>(rl.rlim_cur, registered + 64);
+    if(rl.rlim_max != RLIM_INFINITY && rl.rlim_cur > rl.rlim_max)
+    {
+        rl.rlim_cur = rl.rlim_max;
+    }
+    ::setrlimit(RLIMIT_NOFILE, &rl);
+    ::getrlimit(RLIMIT_NOFILE, &rl);
+    if(rl.rlim_cur != RLIM_INFINITY && static_cast<rlim_t>(registered) + 64 > rl.rlim_cur)
+    {
+        registered = static_cast<int>(rl.rlim_cur) - 64;
+        printf("RLIMIT_NOFILE = %lu, registering %d fds\n",
+                static_cast<unsigned long>(rl.rlim_cur), registered);
+    }
+
+    EventLoop loop;
+    EpollPoller poller(&loop);
+    int rawEpfd = ::epoll_create1(EPOLL_CLOEXEC);
+
+    std::vector<int> fds;
+    std::vector<std::unique_ptr<Channel>> channels;
+    for(int i = 0; i < registered; ++i)
+    {
+        int fd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if(fd < 0)
+        {
+            printf("eventfd failed after %d fds\n", i);
+            break;
+        }
+        fds.push_back(fd);
+        channels.emplace_back(new Channel(&loop, fd));
+    }
+    //enableReading会注册到loop自己的poller上 设置好events后马上移除 再注册到被测的poller上
+    for(auto &channel : channels)
+    {
+        channel->enableReading();
+        channel->remove();
+        poller.updateChannel(channel.get());
+        epoll_event ev = {};
+        ev.events = EPOLLIN | EPOLLPRI;
+        ev.data.fd = channel->fd();
+        ::epoll_ctl(rawEpfd, EPOLL_CTL_ADD, channel->fd(), &ev);
+    }
+
+    std::vector<int> order(fds);
+    std::shuffle(order.begin(), order.end(), std::mt19937(12345));
+    int made = 0;
+    const int actives[] = { 16, 256, 4096 };
+    std::vector<epoll_event> rawEvents(8192);
+    Poller::ChannelList activeChannels;
+    for(int active : actives)
+    {
+        active = std::min(active, static_cast<int>(order.size()));
+        for(; made < active; ++made)
+        {
+            uint64_t one = 1;
+            ::write(order[made], &one, sizeof one);
+        }
+
+        //先跑几轮让events_扩到能一次取完
+        for(int i = 0; i < 16; ++i)
+        {
+            activeChannels.clear();
+            poller.poll(0, &activeChannels);
+        }
+        long events = 0;
+        auto start = std::chrono::steady_clock::now();
+        for(int r = 0; r < rounds; ++r)
+        {
+            activeChannels.clear();
+            poller.poll(0, &activeChannels);
+            for(Channel *channel : activeChannels)
+            {
+                events += channel->revents() != 0;
+            }
+        }
+        double pollNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+        long rawEventsSeen = 0;
+        start = std::chrono::steady_clock::now();
+        for(int r = 0; r < rounds; ++r)
+        {
+            rawEventsSeen += ::epoll_wait(rawEpfd, rawEvents.data(), static_cast<int>(rawEvents.size()), 0);
+        }
+        double rawNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+        double perEvent = pollNs / events;
+        double rawPerEvent = rawNs / rawEventsSeen;
+        printf("%6zu fds %5d ready: poll %7.1f ns/event  epoll_wait %7.1f ns/event  dispatch %6.1f ns/event\n",
+                fds.size(), active, perEvent, rawPerEvent, perEvent - rawPerEvent);
+    }
+
+    for(auto &channel : channels)
+    {
+        poller.removeChannel(channel.get());
+    }
+    for(int fd : fds)
+    {
+        ::close(fd);
+    }
+    ::close(rawEpfd);
+    return 0;
+}
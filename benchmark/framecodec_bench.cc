@@ -0,0 +1,100 @@
+#include <mymuduo/Buffer.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <chrono>
+
+//长度头 + body的帧流以64K的块到达 统计每秒解码的帧数
+//per-frame: 常见的写法 每帧peekInt32/readVarint判断完整性 再retriveAsString取出
+//batch: retriveFrames一遍扫描取出所有完整帧 只retrive一次 body不拷贝
+std::string makeStream(Buffer::LengthPrefix prefix, size_t bodySize, size_t totalBytes)
+{
+    Buffer buf;
+    std::string body(bodySize, 'x');
+    while(buf.readableBytes() < totalBytes)
+    {
+        if(prefix == Buffer::kPrefixVarint)
+        {
+            buf.appendVarint(bodySize);
+        }
+        else
+        {
+            buf.appendInt32(static_cast<int32_t>(bodySize));
+        }
+        buf.append(body.data(), body.size());
+    }
+    return buf.retriveAllAsString();
+}
+
+template<typename Decode>
+void run(const char *name, const std::string &stream, size_t bodySize, Decode decode)
+{
+    const size_t chunk = 64 * 1024;
+    const int rounds = 20;
+    Buffer buf;
+    long frames = 0;
+    long checksum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for(int r = 0; r < rounds; ++r)
+    {
+        for(size_t off = 0; off < stream.size(); off += chunk)
+        {
+            buf.append(stream.data() + off, std::min(chunk, stream.size() - off));
+            frames += decode(&buf, &checksum);
+        }
+    }
+    double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    printf("%-22s body %5zu B: %12.0f frames/s %8.1f MB/s (checksum %ld)\n", name, bodySize,
+            frames / sec, stream.size() * rounds / sec / 1024 / 1024, checksum);
+}
+
+int main()
+{
+    const size_t bodies[] = { 16, 128, 1024 };
+    const size_t total = 16 * 1024 * 1024;
+    for(size_t bodySize : bodies)
+    {
+        std::string fixed = makeStream(Buffer::kPrefixInt32, bodySize, total);
+        std::string varint = makeStream(Buffer::kPrefixVarint, bodySize, total);
+
+        run("int32 per-frame", fixed, bodySize, [](Buffer *buf, long *checksum) {
+            long n = 0;
+            while(buf->readableBytes() >= 4)
+            {
+                size_t len = static_cast<size_t>(buf->peekInt32());
+                if(buf->readableBytes() < 4 + len)
+                {
+                    break;
+                }
+                buf->retrive(4);
+                std::string body = buf->retriveAsString(len);
+                *checksum += body[0];
+                ++n;
+            }
+            return n;
+        });
+        run("int32 batch", fixed, bodySize, [](Buffer *buf, long *checksum) {
+            return buf->retriveFrames(Buffer::kPrefixInt32, 1 << 20,
+                    [checksum](const char *body, size_t) { *checksum += body[0]; });
+        });
+        run("varint per-frame", varint, bodySize, [](Buffer *buf, long *checksum) {
+            long n = 0;
+            uint64_t len = 0;
+            int header = 0;
+            while((header = buf->peekVarint(&len)) > 0 && buf->readableBytes() >= header + len)
+            {
+                buf->retrive(header);
+                std::string body = buf->retriveAsString(len);
+                *checksum += body[0];
+                ++n;
+            }
+            return n;
+        });
+        run("varint batch", varint, bodySize, [](Buffer *buf, long *checksum) {
+            return buf->retriveFrames(Buffer::kPrefixVarint, 1 << 20,
+                    [checksum](const char *body, size_t) { *checksum += body[0]; });
+        });
+    }
+    return 0;
+}
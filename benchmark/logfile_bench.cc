@@ -0,0 +1,35 @@
+#include <mymuduo/LogFile.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <chrono>
+
+//LogFile持续写入的吞吐 MB/s  每行128字节 按rollSize滚动
+int main(int argc, char *argv[])
+{
+    std::string basename = argc > 1 ? argv[1] : "/tmp/logfile_bench";
+    const size_t kTotalBytes = (argc > 2 ? atol(argv[2]) : 2048) * 1024 * 1024;
+    const size_t kRollSize = 512 * 1024 * 1024;
+
+    char line[128];
+    memset(line, 'x', sizeof line);
+    line[sizeof line - 1] = '\n';
+
+    LogFile file(basename, kRollSize, false);
+    auto start = std::chrono::steady_clock::now();
+    size_t written = 0;
+    while(written < kTotalBytes)
+    {
+        file.append(line, sizeof line);
+        written += sizeof line;
+    }
+    file.flush();
+    auto end = std::chrono::steady_clock::now();
+
+    double sec = std::chrono::duration<double>(end - start).count();
+    printf("wrote %zu MB in %.2f s: %.1f MB/s (%.0f lines/s)\n",
+        written >> 20, sec, (written >> 20) / sec, written / sizeof line / sec);
+    return 0;
+}
@@ -0,0 +1,23 @@
+#include <mymuduo/Logger.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+
+//运行期关闭INFO级别后 LOG_INFO在循环中的开销
+int main(int argc, char *argv[])
+{
+    const long kIters = argc > 1 ? atol(argv[1]) : 1000000000L;
+    Logger::setLogLevel(WARN);
+
+    auto start = std::chrono::steady_clock::now();
+    for(long i = 0; i < kIters; ++i)
+    {
+        LOG_INFO("disabled message %ld %s", i, "payload");
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    double ns = std::chrono::duration<double, std::nano>(end - start).count();
+    printf("disabled LOG_INFO: %ld calls, %.3f ns/call\n", kIters, ns / kIters);
+    return 0;
+}
@@ -0,0 +1,71 @@
+#include <mymuduo/Logger.h>
+#include <mymuduo/AsyncLogging.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+#include <thread>
+#include <chrono>
+
+//8个线程同时写日志  对比同步输出到stdout(每行fflush)和AsyncLogging的吞吐
+AsyncLogging *g_asyncLog = nullptr;
+
+void asyncOutput(const char *msg, size_t len)
+{
+    g_asyncLog->append(msg, len);
+}
+
+double run(int numThreads, int linesPerThread)
+{
+    std::vector<std::thread> threads;
+    auto start = std::chrono::steady_clock::now();
+    for(int t = 0; t < numThreads; ++t)
+    {
+        threads.emplace_back([=](){
+            for(int i = 0; i < linesPerThread; ++i)
+            {
+                LOG_INFO("thread %d line %d abcdefghijklmnopqrstuvwxyz %s", t, i, "payload");
+            }
+        });
+    }
+    for(std::thread &thr : threads)
+    {
+        thr.join();
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double>(end - start).count();
+}
+
+int main(int argc, char *argv[])
+{
+    std::string prefix = argc > 1 ? argv[1] : "/tmp/logging_bench";
+    const int kThreads = 8;
+    const int kLines = argc > 2 ? atoi(argv[2]) : 200000;
+    const double total = static_cast<double>(kThreads) * kLines;
+
+    //同步模式: stdout重定向到文件
+    std::string syncFile = prefix + ".sync.log";
+    if(!freopen(syncFile.c_str(), "w", stdout))
+    {
+        perror("freopen");
+        return 1;
+    }
+    double syncSec = run(kThreads, kLines);
+
+    std::string asyncFile = prefix + ".async.log";
+    remove(asyncFile.c_str());
+    {
+        AsyncLogging log(asyncFile);
+        log.start();
+        g_asyncLog = &log;
+        Logger::setOutput(asyncOutput);
+        double asyncSec = run(kThreads, kLines);
+        log.stop();
+
+        fprintf(stderr, "threads: %d  lines: %.0f\n", kThreads, total);
+        fprintf(stderr, "sync  (stdout): %.0f lines/s\n", total / syncSec);
+        fprintf(stderr, "async (writev): %.0f lines/s\n", total / asyncSec);
+    }
+    return 0;
+}
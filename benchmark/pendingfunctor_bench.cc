@@ -0,0 +1,72 @@
+#include <mymuduo/EventLoop.h>
+#include <mymuduo/EventLoopThread.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <chrono>
+
+//1~32个生产者线程同时向同一个loop queueInLoop 统计每秒执行的回调数和每次入队耗时的p99
+//每个回调只给计数器加一 所有回调执行完才停止计时
+int main(int argc, char *argv[])
+{
+    const long total = argc > 1 ? ::atol(argv[1]) : 2000000;
+    EventLoopThread loopThread;
+    EventLoop *loop = loopThread.startLoop();
+
+    const int producerCounts[] = { 1, 2, 4, 8, 16, 32 };
+    for(int producers : producerCounts)
+    {
+        const long perProducer = total / producers;
+        std::atomic<long> executed(0);
+        std::vector<std::vector<int64_t>> latencies(producers);
+        std::vector<std::thread> threads;
+
+        auto start = std::chrono::steady_clock::now();
+        for(int p = 0; p < producers; ++p)
+        {
+            threads.emplace_back([&, p] {
+                std::vector<int64_t> &lat = latencies[p];
+                lat.reserve(perProducer);
+                for(long i = 0; i < perProducer; ++i)
+                {
+                    auto t0 = std::chrono::steady_clock::now();
+                    loop->queueInLoop([&executed] {
+                        executed.store(executed.load(std::memory_order_relaxed) + 1,
+                                       std::memory_order_relaxed);
+                    });
+                    auto t1 = std::chrono::steady_clock::now();
+                    lat.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count());
+                }
+            });
+        }
+        for(std::thread &t : threads)
+        {
+            t.join();
+        }
+        const long expected = perProducer * producers;
+        while(executed.load(std::memory_order_relaxed) < expected)
+        {
+            std::this_thread::yield();
+        }
+        double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        std::vector<int64_t> all;
+        all.reserve(expected);
+        for(const auto &lat : latencies)
+        {
+            all.insert(all.end(), lat.begin(), lat.end());
+        }
+        size_t p50 = all.size() / 2;
+        size_t p99 = all.size() * 99 / 100;
+        std::nth_element(all.begin(), all.begin() + p50, all.end());
+        int64_t p50ns = all[p50];
+        std::nth_element(all.begin(), all.begin() + p99, all.end());
+        printf("%2d producers: %10.0f ops/s  enqueue p50 %6ld ns  p99 %7ld ns\n",
+                producers, expected / sec, static_cast<long>(p50ns), static_cast<long>(all[p99]));
+    }
+    return 0;
+}
@@ -0,0 +1,123 @@
+#include <mymuduo/EventLoop.h>
+#include <mymuduo/EventLoopThread.h>
+#include <mymuduo/Channel.h>
+#include <mymuduo/Logger.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <chrono>
+
+static int64_t nowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+//在loop线程中执行cb并等它完成
+template<typename Func>
+static void runAndWait(EventLoop *loop, Func cb)
+{
+    std::atomic<bool> done(false);
+    loop->runInLoop([&] { cb(); done = true; });
+    while(!done.load())
+    {
+        std::this_thread::yield();
+    }
+}
+
+//loop上注册fds个eventfd 其中一个用来ping 其余一直空闲
+//主线程写ping的eventfd 记录从写入到loop里读回调开始执行的时间 回调再写pong唤醒主线程
+//比较EpollPoller和PollPoller在不同fd数量下的唤醒延迟
+int main(int argc, char *argv[])
+{
+    const int rounds = argc > 1 ? ::atoi(argv[1]) : 20000;
+    Logger::setLogLevel(WARN);
+
+    const char *backends[] = { "epoll", "poll" };
+    const int fdCounts[] = { 4, 64, 1024 };
+    for(int b = 0; b < 2; ++b)
+    {
+        //Poller::newDefaultPoller在EventLoop构造时读环境变量
+        if(b == 1)
+        {
+            ::setenv("MUDUO_USE_POLL", "1", 1);
+        }
+        EventLoopThread loopThread;
+        EventLoop *loop = loopThread.startLoop();
+
+        for(int fds : fdCounts)
+        {
+            const int pongFd = ::eventfd(0, EFD_CLOEXEC);
+            std::vector<int> eventFds;
+            std::vector<std::unique_ptr<Channel>> channels;
+            std::atomic<int64_t> pingTime(0);
+            std::vector<int64_t> latencies;
+            latencies.reserve(rounds);
+
+            runAndWait(loop, [&] {
+                for(int i = 0; i < fds; ++i)
+                {
+                    int fd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+                    eventFds.push_back(fd);
+                    channels.emplace_back(new Channel(loop, fd));
+                    channels.back()->enableReading();
+                }
+                //ping放在最后 poll要扫描整个数组才找到它
+                const int pingFd = eventFds.back();
+                channels.back()->setReadCallback([&, pingFd](Timestamp) {
+                    latencies.push_back(nowNs() - pingTime.load());
+                    uint64_t one;
+                    ::read(pingFd, &one, sizeof one);
+                    one = 1;
+                    ::write(pongFd, &one, sizeof one);
+                });
+            });
+
+            const int pingFd = eventFds.back();
+            const uint64_t one = 1;
+            uint64_t pong;
+            auto start = std::chrono::steady_clock::now();
+            for(int i = 0; i < rounds; ++i)
+            {
+                pingTime = nowNs();
+                ::write(pingFd, &one, sizeof one);
+                ::read(pongFd, &pong, sizeof pong);
+            }
+            double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+            std::sort(latencies.begin(), latencies.end());
+            double mean = 0;
+            for(int64_t ns : latencies)
+            {
+                mean += static_cast<double>(ns);
+            }
+            mean /= latencies.size();
+            printf("%-5s %4d fds: wakeup mean %7.2f us  p50 %7.2f us  p99 %7.2f us  %8.0f round trips/s\n",
+                    backends[b], fds, mean / 1000, latencies[latencies.size() / 2] / 1000.0,
+                    latencies[latencies.size() * 99 / 100] / 1000.0, rounds / sec);
+
+            runAndWait(loop, [&] {
+                for(std::unique_ptr<Channel> &channel : channels)
+                {
+                    channel->disableAll();
+                    channel->remove();
+                }
+                channels.clear();
+                for(int fd : eventFds)
+                {
+                    ::close(fd);
+                }
+            });
+            ::close(pongFd);
+        }
+    }
+    return 0;
+}
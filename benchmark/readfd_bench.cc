@@ -0,0 +1,96 @@
+#include <mymuduo/Buffer.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/uio.h>
+#include <sys/socket.h>
+#include <vector>
+#include <chrono>
+
+//单线程 向socketpair写一条消息 再用readFd读出来 统计每秒处理的读事件数
+//baseline是原来的实现: 每次在栈上清零64K的extrabuf 读取大小固定
+ssize_t oldReadFd(Buffer *buf, int fd, int *saveErrno)
+{
+    char extrabuf[65536] = {0};
+    struct iovec vec[2];
+    const size_t writable = buf->writableBytes();
+    vec[0].iov_base = buf->beginWrite();
+    vec[0].iov_len = writable;
+    vec[1].iov_base = extrabuf;
+    vec[1].iov_len = sizeof extrabuf;
+    const int iovcnt = writable < sizeof extrabuf ? 2 : 1;
+    const ssize_t n = ::readv(fd, vec, iovcnt);
+    if(n < 0)
+    {
+        *saveErrno = errno;
+    }
+    else if(static_cast<size_t>(n) <= writable)
+    {
+        buf->hasWritten(n);
+    }
+    else
+    {
+        buf->hasWritten(writable);
+        buf->append(extrabuf, n - writable);
+    }
+    return n;
+}
+
+template<typename ReadFunc>
+void run(const char *name, size_t msgSize, int messages, ReadFunc readFunc)
+{
+    int fds[2];
+    ::socketpair(AF_UNIX, SOCK_STREAM, 0, fds);
+    int sndbuf = 4 * 1024 * 1024;
+    ::setsockopt(fds[0], SOL_SOCKET, SO_SNDBUF, &sndbuf, sizeof sndbuf);
+    ::setsockopt(fds[1], SOL_SOCKET, SO_RCVBUF, &sndbuf, sizeof sndbuf);
+    std::vector<char> msg(msgSize, 'x');
+
+    Buffer buf;
+    long reads = 0;
+    int saveErrno = 0;
+    auto start = std::chrono::steady_clock::now();
+    for(int i = 0; i < messages; ++i)
+    {
+        size_t sent = 0;
+        while(sent < msgSize)
+        {
+            sent += ::write(fds[0], msg.data() + sent, msgSize - sent);
+        }
+        //一条消息可能需要多次读 模拟handler每次都把数据取走
+        size_t got = 0;
+        while(got < msgSize)
+        {
+            ssize_t n = readFunc(&buf, fds[1], &saveErrno);
+            if(n <= 0)
+            {
+                break;
+            }
+            got += n;
+            ++reads;
+            buf.retriveAll();
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+    double sec = std::chrono::duration<double>(end - start).count();
+    printf("%-10s msg %7zu B: %10.0f read events/s  %5.2f reads/msg  %8.1f MB/s\n",
+        name, msgSize, reads / sec, static_cast<double>(reads) / messages,
+        msgSize * static_cast<double>(messages) / sec / (1024 * 1024));
+    ::close(fds[0]);
+    ::close(fds[1]);
+}
+
+int main(int argc, char *argv[])
+{
+    const int kMessages = argc > 1 ? atoi(argv[1]) : 200000;
+    size_t sizes[] = { 64, 64 * 1024, 1024 * 1024 };
+    for(size_t size : sizes)
+    {
+        int messages = size > 64 * 1024 ? kMessages / 100 : kMessages;
+        run("old", size, messages, oldReadFd);
+        run("readFd", size, messages, [](Buffer *buf, int fd, int *err){ return buf->readFd(fd, err); });
+    }
+    return 0;
+}
@@ -0,0 +1,115 @@
+#include <mymuduo/TcpServer.h>
+#include <mymuduo/EventLoop.h>
+#include <mymuduo/EventLoopThread.h>
+#include <mymuduo/InetAddress.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <chrono>
+
+//替换write 统计8字节的写(本程序中只有唤醒loop的eventfd)
+static std::atomic<long> g_wakeups(0);
+
+extern "C" ssize_t write(int fd, const void *buf, size_t count)
+{
+    if(count == sizeof(uint64_t))
+    {
+        g_wakeups.fetch_add(1, std::memory_order_relaxed);
+    }
+    return ::syscall(SYS_write, fd, buf, count);
+}
+
+//短连接: 客户端connect后等服务端shutdown(读到EOF)再close
+//比较 baseloop accept后轮询分发给subloop / 每个loop一个SO_REUSEPORT监听socket 在1个和16个loop下的每秒连接数
+int main(int argc, char *argv[])
+{
+    const double seconds = argc > 1 ? ::atof(argv[1]) : 2.0;
+    const int clients = 4;
+    Logger::setLogLevel(WARN);
+
+    const TcpServer::Option options[] = { TcpServer::kNoReusePort, TcpServer::kReusePortPerLoop };
+    const char *modes[] = { "dispatch", "per-loop" };
+    const int loopCounts[] = { 1, 16 };
+    uint16_t port = 9140;
+    for(int m = 0; m < 2; ++m)
+    {
+        for(int loops : loopCounts)
+        {
+            EventLoopThread loopThread;
+            EventLoop *loop = loopThread.startLoop();
+            InetAddress addr(port);
+            TcpServer *server = nullptr;
+            //TcpServer在baseloop线程中构造和start
+            std::atomic<bool> ready(false);
+            loop->runInLoop([&] {
+                server = new TcpServer(loop, addr, modes[m], options[m]);
+                server->setConnectionCallback([](const TcpConnectionPtr &conn) {
+                    if(conn->connected())
+                    {
+                        conn->shutdown();
+                    }
+                });
+                server->setThreadNum(loops);
+                server->start();
+                ready = true;
+            });
+            while(!ready.load())
+            {
+                ::usleep(1000);
+            }
+
+            std::atomic<long> connections(0);
+            long wakeupsBefore = g_wakeups.load();
+            auto start = std::chrono::steady_clock::now();
+            auto deadline = start + std::chrono::duration<double>(seconds);
+            std::vector<std::thread> threads;
+            for(int c = 0; c < clients; ++c)
+            {
+                threads.emplace_back([&] {
+                    sockaddr_in serverAddr = {};
+                    serverAddr.sin_family = AF_INET;
+                    serverAddr.sin_port = htons(port);
+                    serverAddr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+                    char buf[16];
+                    while(std::chrono::steady_clock::now() < deadline)
+                    {
+                        int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+                        if(::connect(fd, reinterpret_cast<sockaddr*>(&serverAddr), sizeof serverAddr) == 0
+                            && ::read(fd, buf, sizeof buf) == 0)
+                        {
+                            ++connections;
+                        }
+                        ::close(fd);
+                    }
+                });
+            }
+            for(std::thread &t : threads)
+            {
+                t.join();
+            }
+            double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            long wakeups = g_wakeups.load() - wakeupsBefore;
+            printf("%-8s %2d loops: %8.0f conns/s  %.2f loop wakeups/conn\n", modes[m], loops,
+                    connections / sec, static_cast<double>(wakeups) / connections);
+
+            ready = false;
+            loop->runInLoop([&] {
+                delete server;
+                ready = true;
+            });
+            while(!ready.load())
+            {
+                ::usleep(1000);
+            }
+            ++port;
+        }
+    }
+    return 0;
+}
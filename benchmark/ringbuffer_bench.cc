@@ -0,0 +1,74 @@
+#include <mymuduo/Buffer.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <vector>
+#include <chrono>
+
+//半包场景: 4字节长度头 + body的帧 以和帧边界不对齐的chunk追加进Buffer
+//每次追加后解析出所有完整的帧 剩下的半帧留在Buffer里等下一个chunk
+//普通Buffer在可写空间不够时要把半帧makespace搬到前面 magic ring不需要搬移
+void run(const char *name, bool ring, size_t frameSize, size_t chunkSize, size_t totalBytes)
+{
+    //准备一段首尾相接的帧流
+    std::vector<char> stream(frameSize * 64);
+    for(size_t off = 0; off < stream.size(); off += frameSize)
+    {
+        uint32_t len = static_cast<uint32_t>(frameSize - 4);
+        memcpy(&stream[off], &len, 4);
+        memset(&stream[off + 4], 'x', frameSize - 4);
+    }
+
+    Buffer buf;
+    if(ring && !buf.enableRing(4 * chunkSize))
+    {
+        printf("enableRing failed\n");
+        return;
+    }
+
+    size_t pos = 0;
+    long frames = 0;
+    uint64_t checksum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for(size_t fed = 0; fed < totalBytes; fed += chunkSize)
+    {
+        size_t n = chunkSize;
+        while(n > 0)
+        {
+            size_t piece = std::min(n, stream.size() - pos);
+            buf.append(&stream[pos], piece);
+            pos = (pos + piece) % stream.size();
+            n -= piece;
+        }
+        while(buf.readableBytes() >= 4)
+        {
+            uint32_t len;
+            memcpy(&len, buf.peek(), 4);
+            if(buf.readableBytes() < 4 + len)
+            {
+                break;
+            }
+            checksum += static_cast<unsigned char>(buf.peek()[4 + len - 1]);
+            buf.retrive(4 + len);
+            ++frames;
+        }
+    }
+    double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    printf("%-6s frame %6zu B chunk %6zu B: %10.0f frames/s %8.1f MB/s (checksum %lu)\n",
+            name, frameSize, chunkSize, frames / sec, totalBytes / sec / 1024 / 1024,
+            static_cast<unsigned long>(checksum));
+}
+
+int main(int argc, char *argv[])
+{
+    size_t total = argc > 1 ? ::atol(argv[1]) : 2UL * 1024 * 1024 * 1024;
+    const size_t cases[][2] = { {100, 4096}, {3000, 4096}, {9000, 16384}, {40000, 65536} };
+    for(const auto &c : cases)
+    {
+        run("linear", false, c[0], c[1], total);
+        run("ring", true, c[0], c[1], total);
+    }
+    return 0;
+}
@@ -0,0 +1,156 @@
+#include <mymuduo/TcpServer.h>
+#include <mymuduo/EventLoop.h>
+#include <mymuduo/EventLoopThread.h>
+#include <mymuduo/InetAddress.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <atomic>
+#include <new>
+#include <string>
+#include <thread>
+#include <chrono>
+
+//替换全局operator new 统计整个进程的堆分配次数 t_allocs是本线程的
+static std::atomic<long> g_allocs(0);
+static __thread long t_allocs = 0;
+
+void* operator new(size_t size)
+{
+    g_allocs.fetch_add(1, std::memory_order_relaxed);
+    ++t_allocs;
+    void *p = ::malloc(size);
+    if(p == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void *p) noexcept
+{
+    ::free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+    ::free(p);
+}
+
+//loop线程之外的线程对同一个连接反复send 客户端线程把数据读走
+//统计每次send平均触发的堆分配次数(包括loop线程中执行发送时的分配)
+int main(int argc, char *argv[])
+{
+    const int sends = argc > 1 ? ::atoi(argv[1]) : 200000;
+    const uint16_t port = 9125;
+
+    EventLoopThread loopThread;
+    EventLoop *loop = loopThread.startLoop();
+    std::atomic<TcpConnection*> connection(nullptr);
+    TcpConnectionPtr holder;
+
+    InetAddress addr(port);
+    TcpServer server(loop, addr, "sendalloc");
+    server.setConnectionCallback([&](const TcpConnectionPtr &conn) {
+        if(conn->connected())
+        {
+            holder = conn;
+            connection = conn.get();
+        }
+        else
+        {
+            holder.reset();     //放掉连接 socket才会关闭 reader线程读到EOF
+        }
+    });
+    server.setMessageCallback([](const TcpConnectionPtr&, Buffer *buf, Timestamp) { buf->retriveAll(); });
+    loop->runInLoop([&server] { server.start(); });
+
+    int client = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in serverAddr = {};
+    serverAddr.sin_family = AF_INET;
+    serverAddr.sin_port = htons(port);
+    serverAddr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    while(::connect(client, reinterpret_cast<sockaddr*>(&serverAddr), sizeof serverAddr) < 0)
+    {
+        ::usleep(1000);
+    }
+    while(connection.load() == nullptr)
+    {
+        ::usleep(1000);
+    }
+    TcpConnection *conn = connection.load();
+
+    std::atomic<long> received(0);
+    std::thread reader([&] {
+        char buf[65536];
+        ssize_t n;
+        while((n = ::read(client, buf, sizeof buf)) > 0)
+        {
+            received += n;
+        }
+    });
+
+    //预热 让FunctorQueue的节点缓存先分配好
+    {
+        long expected = received.load() + 8L * sends;
+        for(int i = 0; i < sends; ++i)
+        {
+            conn->send(std::string(8, 'x'));
+        }
+        while(received.load() < expected)
+        {
+            ::usleep(100);
+        }
+    }
+
+    const size_t sizes[] = { 8, 100, 1000 };
+    for(size_t size : sizes)
+    {
+        std::string payload(size, 'x');
+        for(int mode = 0; mode < 3; ++mode)
+        {
+            long expected = received.load() + static_cast<long>(size) * sends;
+            long before = g_allocs.load();
+            long excluded = 0;  //调用者自己构造消息的分配 不计入send
+            auto start = std::chrono::steady_clock::now();
+            for(int i = 0; i < sends; ++i)
+            {
+                if(mode == 0)
+                {
+                    conn->send(payload);
+                }
+                else if(mode == 1)
+                {
+                    long self = t_allocs;
+                    std::string msg(payload);
+                    excluded += t_allocs - self;
+                    conn->send(std::move(msg));
+                }
+                else
+                {
+                    long self = t_allocs;
+                    Buffer buf;
+                    buf.append(payload.data(), payload.size());
+                    excluded += t_allocs - self;
+                    conn->send(&buf);
+                }
+            }
+            while(received.load() < expected)
+            {
+                ::usleep(100);
+            }
+            double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            static const char *names[] = { "send(const string&)", "send(string&&)", "send(Buffer*)" };
+            printf("%-20s %5zu B: %5.2f allocs/send  %9.0f sends/s\n", names[mode], size,
+                    static_cast<double>(g_allocs.load() - before - excluded) / sends, sends / sec);
+        }
+    }
+
+    ::shutdown(client, SHUT_WR);
+    reader.join();
+    ::close(client);
+    return 0;
+}
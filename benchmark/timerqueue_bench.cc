@@ -0,0 +1,44 @@
+#include <mymuduo/EventLoop.h>
+#include <mymuduo/TimerId.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+#include <chrono>
+
+//在一个loop上挂载并取消1M个定时器  统计每次操作的平均耗时
+int main(int argc, char *argv[])
+{
+    const int kTimers = argc > 1 ? atoi(argv[1]) : 1000000;
+    EventLoop loop;
+    std::vector<TimerId> ids;
+    ids.reserve(kTimers);
+    srand(1);
+
+    auto start = std::chrono::steady_clock::now();
+    for(int i = 0; i < kTimers; ++i)
+    {
+        //超时时间随机分布在 [100s, 1100s) 保证测试期间不会到期
+        double delay = 100.0 + (rand() % 1000000) / 1000.0;
+        ids.push_back(loop.runAfter(delay, [](){}));
+    }
+    auto armed = std::chrono::steady_clock::now();
+
+    //以随机顺序取消 避免总是删除堆尾
+    for(int i = kTimers - 1; i > 0; --i)
+    {
+        std::swap(ids[i], ids[rand() % (i + 1)]);
+    }
+    for(const TimerId &id : ids)
+    {
+        loop.cancel(id);
+    }
+    auto canceled = std::chrono::steady_clock::now();
+
+    double armNs = std::chrono::duration<double, std::nano>(armed - start).count();
+    double cancelNs = std::chrono::duration<double, std::nano>(canceled - armed).count();
+    printf("timers: %d\n", kTimers);
+    printf("arm:    %.3f s total, %.1f ns/op\n", armNs / 1e9, armNs / kTimers);
+    printf("cancel: %.3f s total, %.1f ns/op\n", cancelNs / 1e9, cancelNs / kTimers);
+    return 0;
+}
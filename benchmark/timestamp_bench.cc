@@ -0,0 +1,36 @@
+#include <mymuduo/Timestamp.h>
+#include <mymuduo/EventLoop.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <chrono>
+
+//各种获取当前时间的方式每次调用的开销
+template<typename F>
+void bench(const char *name, long iters, F f)
+{
+    int64_t sink = 0;
+    auto start = std::chrono::steady_clock::now();
+    for(long i = 0; i < iters; ++i)
+    {
+        sink += f();
+        asm volatile("" ::: "memory"); //防止缓存的时间读取被提到循环外
+    }
+    auto end = std::chrono::steady_clock::now();
+    double ns = std::chrono::duration<double, std::nano>(end - start).count();
+    printf("%-36s %6.2f ns/call  (%ld)\n", name, ns / iters, static_cast<long>(sink & 1));
+}
+
+int main(int argc, char *argv[])
+{
+    const long kIters = argc > 1 ? atol(argv[1]) : 20000000L;
+    EventLoop loop;
+
+    bench("time(NULL)", kIters, [](){ return static_cast<int64_t>(::time(NULL)); });
+    bench("Timestamp::now()", kIters, [](){ return Timestamp::now().microSecondsSinceEpoch(); });
+    bench("Timestamp::monotonicMicroseconds()", kIters, [](){ return Timestamp::monotonicMicroseconds(); });
+    bench("EventLoop::pollReturnMonotonic()", kIters, [&](){ return loop.pollReturnMonotonic(); });
+    bench("EventLoop::pollReturnTime()", kIters, [&](){ return loop.pollReturnTime().microSecondsSinceEpoch(); });
+    return 0;
+}
@@ -0,0 +1,47 @@
+#include <mymuduo/EventLoop.h>
+#include <mymuduo/TimingWheel.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+#include <chrono>
+
+//时间轮上注册1M个连接  统计每次读事件touch的开销
+int main(int argc, char *argv[])
+{
+    const int kEntries = argc > 1 ? atoi(argv[1]) : 1000000;
+    const int kTouches = 10 * kEntries;
+    EventLoop loop;
+    TimingWheel *wheel = loop.timingWheel();
+    TimingWheel::Entry *entries = new TimingWheel::Entry[kEntries];
+
+    auto start = std::chrono::steady_clock::now();
+    for(int i = 0; i < kEntries; ++i)
+    {
+        wheel->add(&entries[i], 30.0 + i % 60, [](){});
+    }
+    auto added = std::chrono::steady_clock::now();
+
+    //随机访问模拟读事件分布在不同连接上
+    std::vector<int> order(kTouches);
+    srand(1);
+    for(int &index : order)
+    {
+        index = rand() % kEntries;
+    }
+    auto touchStart = std::chrono::steady_clock::now();
+    for(int index : order)
+    {
+        entries[index].touch();
+    }
+    auto touched = std::chrono::steady_clock::now();
+
+    double addNs = std::chrono::duration<double, std::nano>(added - start).count();
+    double touchNs = std::chrono::duration<double, std::nano>(touched - touchStart).count();
+    printf("registered: %zu\n", wheel->size());
+    printf("add:   %.1f ns/op\n", addNs / kEntries);
+    printf("touch: %.1f ns/op (%d random touches)\n", touchNs / kTouches, kTouches);
+
+    delete[] entries;
+    return 0;
+}
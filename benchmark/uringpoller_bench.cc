@@ -0,0 +1,143 @@
+#include <mymuduo/TcpServer.h>
+#include <mymuduo/EventLoop.h>
+#include <mymuduo/EventLoopThread.h>
+#include <mymuduo/InetAddress.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <unistd.h>
+#include <dlfcn.h>
+#include <poll.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <atomic>
+#include <string>
+#include <vector>
+#include <chrono>
+
+//统计poller的系统调用: epoll_wait epoll_ctl 以及通过syscall()调用的io_uring_enter
+static std::atomic<long> g_pollerCalls(0);
+
+extern "C" int epoll_wait(int epfd, struct epoll_event *events, int maxevents, int timeout)
+{
+    g_pollerCalls.fetch_add(1, std::memory_order_relaxed);
+    return static_cast<int>(::syscall(SYS_epoll_pwait, epfd, events, maxevents, timeout, nullptr, 8));
+}
+
+extern "C" int epoll_ctl(int epfd, int op, int fd, struct epoll_event *event)
+{
+    g_pollerCalls.fetch_add(1, std::memory_order_relaxed);
+    return static_cast<int>(::syscall(SYS_epoll_ctl, epfd, op, fd, event));
+}
+
+extern "C" long syscall(long number, ...)
+{
+    typedef long (*SyscallFunc)(long, ...);
+    static SyscallFunc realSyscall = reinterpret_cast<SyscallFunc>(::dlsym(RTLD_NEXT, "syscall"));
+    va_list ap;
+    va_start(ap, number);
+    long a[6];
+    for(int i = 0; i < 6; ++i)
+    {
+        a[i] = va_arg(ap, long);
+    }
+    va_end(ap);
+    if(number == SYS_io_uring_enter)
+    {
+        g_pollerCalls.fetch_add(1, std::memory_order_relaxed);
+    }
+    return realSyscall(number, a[0], a[1], a[2], a[3], a[4], a[5]);
+}
+
+//conns个连接各自一问一答地发msgSize字节的消息 客户端用poll驱动(不计入统计)
+//比较EpollPoller和IoUringPoller每条消息的poller系统调用次数和吞吐
+int main(int argc, char *argv[])
+{
+    const double seconds = argc > 1 ? ::atof(argv[1]) : 2.0;
+    const size_t msgSize = 64;
+    Logger::setLogLevel(WARN);
+
+    const char *backends[] = { "epoll", "io_uring" };
+    const int connCounts[] = { 1, 16, 256 };
+    for(int b = 0; b < 2; ++b)
+    {
+        //Poller::newDefaultPoller在EventLoop构造时读环境变量
+        if(b == 1)
+        {
+            ::setenv("MUDUO_USE_URING", "1", 1);
+        }
+        EventLoopThread loopThread;
+        EventLoop *loop = loopThread.startLoop();
+        const uint16_t port = static_cast<uint16_t>(9129 + b);
+        InetAddress addr(port);
+        TcpServer server(loop, addr, backends[b]);
+        server.setConnectionCallback([](const TcpConnectionPtr&) {});
+        server.setMessageCallback([](const TcpConnectionPtr &conn, Buffer *buf, Timestamp) {
+            conn->send(buf);
+        });
+        loop->runInLoop([&server] { server.start(); });
+
+        for(int conns : connCounts)
+        {
+            std::vector<pollfd> fds(conns);
+            for(int i = 0; i < conns; ++i)
+            {
+                int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+                sockaddr_in serverAddr = {};
+                serverAddr.sin_family = AF_INET;
+                serverAddr.sin_port = htons(port);
+                serverAddr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+                while(::connect(fd, reinterpret_cast<sockaddr*>(&serverAddr), sizeof serverAddr) < 0)
+                {
+                    ::usleep(1000);
+                }
+                fds[i].fd = fd;
+                fds[i].events = POLLIN;
+            }
+            ::usleep(50000);
+
+            const std::string msg(msgSize, 'm');
+            char buf[4096];
+            long messages = 0;
+            long callsBefore = g_pollerCalls.load();
+            auto start = std::chrono::steady_clock::now();
+            auto deadline = start + std::chrono::duration<double>(seconds);
+            for(pollfd &p : fds)
+            {
+                ::write(p.fd, msg.data(), msg.size());
+            }
+            while(std::chrono::steady_clock::now() < deadline)
+            {
+                int n = ::poll(fds.data(), fds.size(), 1000);
+                for(int i = 0; i < conns && n > 0; ++i)
+                {
+                    if(fds[i].revents & POLLIN)
+                    {
+                        --n;
+                        ssize_t got = ::read(fds[i].fd, buf, sizeof buf);
+                        //消息很小 一次就能读完整条回显
+                        if(got > 0)
+                        {
+                            ++messages;
+                            ::write(fds[i].fd, msg.data(), msg.size());
+                        }
+                    }
+                }
+            }
+            double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            long calls = g_pollerCalls.load() - callsBefore;
+            printf("%-8s %3d conns: %9.0f msgs/s  %.3f poller syscalls/msg\n", backends[b], conns,
+                    messages / sec, static_cast<double>(calls) / messages);
+            //每个连接还有一条回显在路上 读完再关 避免服务端收到RST
+            for(pollfd &p : fds)
+            {
+                ::read(p.fd, buf, sizeof buf);
+                ::close(p.fd);
+            }
+            ::usleep(50000);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,77 @@
+#include <mymuduo/EventLoop.h>
+#include <mymuduo/EventLoopThread.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <chrono>
+
+//替换write 统计8字节的写(本程序中只有写eventfd的wakeup)
+static std::atomic<long> g_eventfdWrites(0);
+
+extern "C" ssize_t write(int fd, const void *buf, size_t count)
+{
+    if(count == sizeof(uint64_t))
+    {
+        g_eventfdWrites.fetch_add(1, std::memory_order_relaxed);
+    }
+    return ::syscall(SYS_write, fd, buf, count);
+}
+
+//producers个线程每次连续投递burst个回调到同一个loop 统计每个回调平均触发多少次eventfd写
+int main(int argc, char *argv[])
+{
+    const long total = argc > 1 ? ::atol(argv[1]) : 500000;
+    EventLoopThread loopThread;
+    EventLoop *loop = loopThread.startLoop();
+
+    const int producerCounts[] = { 1, 4, 16 };
+    const int bursts[] = { 1, 16, 1000 };
+    for(int producers : producerCounts)
+    {
+        for(int burst : bursts)
+        {
+            const long perProducer = total / producers / burst * burst;
+            std::atomic<long> executed(0);
+            std::vector<std::thread> threads;
+            long writesBefore = g_eventfdWrites.load();
+
+            auto start = std::chrono::steady_clock::now();
+            for(int p = 0; p < producers; ++p)
+            {
+                threads.emplace_back([&] {
+                    for(long i = 0; i < perProducer; i += burst)
+                    {
+                        for(int j = 0; j < burst; ++j)
+                        {
+                            loop->queueInLoop([&executed] {
+                                executed.store(executed.load(std::memory_order_relaxed) + 1,
+                                               std::memory_order_relaxed);
+                            });
+                        }
+                        //burst之间让出CPU 给loop机会把队列取空 进入epoll_wait
+                        std::this_thread::yield();
+                    }
+                });
+            }
+            for(std::thread &t : threads)
+            {
+                t.join();
+            }
+            const long expected = perProducer * producers;
+            while(executed.load(std::memory_order_relaxed) < expected)
+            {
+                std::this_thread::yield();
+            }
+            double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            long writes = g_eventfdWrites.load() - writesBefore;
+            printf("%2d producers burst %4d: %10.0f ops/s  %9ld eventfd writes  %.4f writes/post\n",
+                    producers, burst, expected / sec, writes, static_cast<double>(writes) / expected);
+        }
+    }
+    return 0;
+}
@@ -47,8 +47,7 @@ private:
             Buffer *buf,
             Timestamp time)
     {
-        std::string msg = buf->retriveAllAsString();
-        conn->send(msg);
+        conn->send(buf); //直接发送输入缓冲区中的数据 不拷贝成string
         conn->shutdown(); //关闭写端 EPOLLHUP => closeCallback_
     }
     EventLoop *loop_;
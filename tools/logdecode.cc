@@ -0,0 +1,260 @@
+/*
+mymuduo-logdecode  把BinaryLogging写出的二进制日志还原成文本
+    ./mymuduo-logdecode server.blog > server.log
+输出格式和Logger的文本日志相同 时间精确到微秒并带上tid
+文件格式见 BinaryLogging.h
+*/
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+const uint32_t kDefinitionId = 0xFFFFFFFF;
+const size_t kRecordHeaderSize = 4 + 4 + 8 + 4;
+
+struct Format
+{
+    int level;
+    int line;
+    std::string file;
+    std::string signature;
+    std::string format;
+};
+
+const char* levelName(int level)
+{
+    static const char *names[] = { "[DEBUG]", "[INFO]", "[WARN]", "[ERROE]", "[FATAL]" };
+    return level >= 0 && level < 5 ? names[level] : "";
+}
+
+template<typename T>
+bool readPod(const char *&p, const char *end, T *value)
+{
+    if(static_cast<size_t>(end - p) < sizeof(T))
+    {
+        return false;
+    }
+    memcpy(value, p, sizeof(T));
+    p += sizeof(T);
+    return true;
+}
+
+bool readCString(const char *&p, const char *end, std::string *value)
+{
+    const char *zero = static_cast<const char*>(memchr(p, '\0', end - p));
+    if(zero == nullptr)
+    {
+        return false;
+    }
+    value->assign(p, zero);
+    p = zero + 1;
+    return true;
+}
+
+//按照格式串逐个取出参数 每个转换说明单独交给snprintf
+std::string formatRecord(const Format &fmt, const char *args, const char *end)
+{
+    std::string out;
+    const std::string &f = fmt.format;
+    size_t argIndex = 0;
+    char buf[512];
+    size_t i = 0;
+    while(i < f.size())
+    {
+        if(f[i] != '%')
+        {
+            out.push_back(f[i++]);
+            continue;
+        }
+        if(i + 1 < f.size() && f[i + 1] == '%')
+        {
+            out.push_back('%');
+            i += 2;
+            continue;
+        }
+
+        //% [flags] [width] [.precision] [length] conversion
+        size_t start = i++;
+        while(i < f.size() && strchr("-+ #0'", f[i]))
+        {
+            ++i;
+        }
+        while(i < f.size() && ((f[i] >= '0' && f[i] <= '9') || f[i] == '.'))
+        {
+            ++i;
+        }
+        std::string spec = f.substr(start, i - start);  //去掉长度修饰符 后面按参数类型重新加上
+        while(i < f.size() && strchr("hlLqjzt", f[i]))
+        {
+            ++i;
+        }
+        if(i >= f.size())
+        {
+            break;
+        }
+        char conv = f[i++];
+
+        if(argIndex >= fmt.signature.size())
+        {
+            out += "<missing>";
+            continue;
+        }
+        char type = fmt.signature[argIndex++];
+        int n = 0;
+        if(type == 'i' || type == 'u')
+        {
+            int64_t v;
+            if(!readPod(args, end, &v))
+            {
+                return out + "<truncated>";
+            }
+            if(conv == 'c')
+            {
+                n = snprintf(buf, sizeof buf, (spec + conv).c_str(), static_cast<int>(v));
+            }
+            else if(conv == 's')
+            {
+                n = snprintf(buf, sizeof buf, "%lld", static_cast<long long>(v));
+            }
+            else
+            {
+                n = snprintf(buf, sizeof buf, (spec + "ll" + conv).c_str(), static_cast<long long>(v));
+            }
+        }
+        else if(type == 'd')
+        {
+            double v;
+            if(!readPod(args, end, &v))
+            {
+                return out + "<truncated>";
+            }
+            n = snprintf(buf, sizeof buf, (spec + conv).c_str(), v);
+        }
+        else if(type == 'p')
+        {
+            uint64_t v;
+            if(!readPod(args, end, &v))
+            {
+                return out + "<truncated>";
+            }
+            n = snprintf(buf, sizeof buf, (spec + 'p').c_str(), reinterpret_cast<void*>(v));
+        }
+        else if(type == 's')
+        {
+            uint32_t len;
+            if(!readPod(args, end, &len) || static_cast<size_t>(end - args) < len)
+            {
+                return out + "<truncated>";
+            }
+            std::string s(args, len);
+            args += len;
+            n = snprintf(buf, sizeof buf, (spec + 's').c_str(), s.c_str());
+        }
+        if(n > 0)
+        {
+            out.append(buf, static_cast<size_t>(n) < sizeof buf ? n : sizeof buf - 1);
+        }
+    }
+    return out;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    if(argc < 2)
+    {
+        fprintf(stderr, "usage: %s file.blog\n", argv[0]);
+        return 1;
+    }
+    FILE *fp = fopen(argv[1], "rb");
+    if(fp == nullptr)
+    {
+        perror("fopen");
+        return 1;
+    }
+    std::vector<char> data;
+    char chunk[65536];
+    size_t n;
+    while((n = fread(chunk, 1, sizeof chunk, fp)) > 0)
+    {
+        data.insert(data.end(), chunk, chunk + n);
+    }
+    fclose(fp);
+
+    const char *p = data.data();
+    const char *end = p + data.size();
+    uint32_t version = 0;
+    if(data.size() < 12 || memcmp(p, "MYMDBLOG", 8) != 0)
+    {
+        fprintf(stderr, "%s: not a binary log file\n", argv[1]);
+        return 1;
+    }
+    p += 8;
+    readPod(p, end, &version);
+
+    std::vector<Format> formats;
+    while(p < end)
+    {
+        const char *entry = p;
+        uint32_t len, id;
+        if(!readPod(p, end, &len) || !readPod(p, end, &id)
+            || len < 8 || static_cast<size_t>(end - entry) < len)
+        {
+            fprintf(stderr, "truncated entry at offset %ld\n", static_cast<long>(entry - data.data()));
+            break;
+        }
+        const char *entryEnd = entry + len;
+        if(id == kDefinitionId)
+        {
+            uint32_t formatId;
+            int32_t level, line;
+            Format fmt;
+            if(readPod(p, entryEnd, &formatId) && readPod(p, entryEnd, &level)
+                && readPod(p, entryEnd, &line) && readCString(p, entryEnd, &fmt.file)
+                && readCString(p, entryEnd, &fmt.signature) && readCString(p, entryEnd, &fmt.format))
+            {
+                fmt.level = level;
+                fmt.line = line;
+                if(formats.size() <= formatId)
+                {
+                    formats.resize(formatId + 1);
+                }
+                formats[formatId] = fmt;
+            }
+        }
+        else if(id < formats.size() && len >= kRecordHeaderSize)
+        {
+            int64_t micros = 0;
+            int32_t tid = 0;
+            readPod(p, entryEnd, &micros);
+            readPod(p, entryEnd, &tid);
+            const Format &fmt = formats[id];
+
+            time_t seconds = static_cast<time_t>(micros / 1000000);
+            struct tm tm_time;
+            localtime_r(&seconds, &tm_time);
+            std::string msg = formatRecord(fmt, p, entryEnd);
+            printf("%stime : %4d/%02d/%02d %02d:%02d:%02d.%06d : %d : %s",
+                levelName(fmt.level),
+                tm_time.tm_year + 1900, tm_time.tm_mon + 1, tm_time.tm_mday,
+                tm_time.tm_hour, tm_time.tm_min, tm_time.tm_sec,
+                static_cast<int>(micros % 1000000), tid, msg.c_str());
+            if(msg.empty() || msg[msg.size() - 1] != '\n')
+            {
+                putchar('\n');
+            }
+        }
+        else
+        {
+            fprintf(stderr, "unknown format id %u\n", id);
+        }
+        p = entryEnd;
+    }
+    return 0;
+}